@@ -4,9 +4,11 @@
 #include <optional>
 #include <string>
 
+#include "common/snapshot.hpp"
+#include "common/stats.hpp"
 #include "common/utils.hpp"
 #include "linked_hashmap.h"
-#include "storage/index/b_plus_tree.h"
+#include "storage/index/extendible_hash_table.h"
 namespace CrazyDave {
 class AccountSystem;
 class Account {
@@ -30,9 +32,9 @@ class ManagementSystem;
 class AccountSystem {
  private:
 #ifdef DEBUG_FILE_IN_TMP
-  BPT<size_t, Account> account_storage_{"tmp/ac", 0, 300, 30};
+  EHT<size_t, Account> account_storage_{"tmp/ac", 0, 300, 30};
 #else
-  BPT<size_t, Account> account_storage_{"ac", 0, 60, 5};
+  EHT<size_t, Account> account_storage_{"ac", 0, 60, 5};
 
 #endif
   linked_hashmap<size_t, int> login_list_;
@@ -59,6 +61,12 @@ class AccountSystem {
                       const std::optional<std::string> &password, const std::optional<std::string> &name,
                       const std::optional<std::string> &mail_addr, std::optional<int> privilege) -> bool;
   void clear();
+  void print_stats(std::ostream &os);
+  void save(SnapshotWriter &writer);
+  /*
+   * 用快照里的用户替换现有的全部用户，所有用户都登出
+   */
+  auto load(SnapshotReader &reader) -> bool;
 };
 }  // namespace CrazyDave
 #endif  // TICKET_SYSTEM_ACCOUNT_HPP
@@ -15,6 +15,10 @@ class ManagementSystem {
  private:
   AccountSystem *account_sys_;
   TrainSystem *train_sys_;
+  // periodic stats dump, enabled by `stats -f <file> -n <interval>`
+  std::ofstream stats_file_;
+  int stats_interval_{0};
+  int commands_since_dump_{0};
   auto execute_line(const std::string &line) -> bool;
 
  public:
@@ -22,6 +26,18 @@ class ManagementSystem {
   ~ManagementSystem();
   void run();
   auto check_is_login(const std::string &username) -> bool;
+  /*
+   * 输出各命令计数、各索引的形状与缓冲池计数、候补队列长度等运行时统计
+   */
+  void print_stats(std::ostream &os);
+  /*
+   * 把全部用户、车次、订单和候补队列存成一个快照文件，见 common/snapshot.hpp
+   */
+  auto save_snapshot(const std::string &path) -> bool;
+  /*
+   * 用快照文件替换现有的全部数据，文件损坏或版本不对时什么也不改
+   */
+  auto load_snapshot(const std::string &path) -> bool;
 };
 }  // namespace CrazyDave
 #endif  // TICKETSYSTEM_MANAGEMENT_SYSTEM_HPP
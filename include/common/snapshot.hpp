@@ -0,0 +1,147 @@
+#ifndef TICKETSYSTEM_SNAPSHOT_HPP
+#define TICKETSYSTEM_SNAPSHOT_HPP
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "common/utils.hpp"
+
+namespace CrazyDave {
+/*
+ * 快照把整个数据库顺序写进一个文件：
+ *   magic (8) | version (4) | 段 ... | END (4) | checksum (8)
+ * 每段是 tag (4) | 条目大小 (4)，之后是若干块，每块是条目数 (4) 加这么多条目，条目数为 0 的块结束这一段，
+ * 所以写的时候不必先数一段有多少条目。checksum 是它前面所有字节的 FNV-1a。
+ * 条目是内存里结构体的原样字节，结构体一变就要改 SNAPSHOT_VERSION，读的时候也会核对每段的条目大小。
+ */
+enum class SnapshotSection : uint32_t {
+  END = 0,
+  ACCOUNT_HEADER,
+  ACCOUNTS,
+  TRAIN_ARRAYS,
+  SEAT_PAGES,
+  TRAIN_METAS,
+  TRADES,
+  STATIONS,
+  QUEUE
+};
+
+class SnapshotWriter {
+ public:
+  // 先写到 <path>.tmp，close() 成功时再改名成 path，写到一半的文件不会顶替旧的快照
+  explicit SnapshotWriter(const std::string &path);
+  ~SnapshotWriter();
+  auto is_open() const -> bool { return out_.is_open(); }
+
+  template <class... T>
+  void begin_section(SnapshotSection section) {
+    write_bytes(&section, sizeof(section));
+    uint32_t entry_size = (sizeof(T) + ...);
+    write_bytes(&entry_size, sizeof(entry_size));
+  }
+  // 一个条目由 parts 依次拼成
+  template <class... T>
+  void append(const T &...parts) {
+    static_assert((sizeof(T) + ...) <= CHUNK_SIZE);
+    if (buffer_size_ + (sizeof(T) + ...) > CHUNK_SIZE) {
+      flush_chunk();
+    }
+    ((std::memcpy(buffer_ + buffer_size_, &parts, sizeof(T)), buffer_size_ += sizeof(T)), ...);
+    ++chunk_count_;
+  }
+  void end_section();
+  // 写结束标记和 checksum，返回是否全部写成功
+  auto close() -> bool;
+
+ private:
+  static constexpr size_t CHUNK_SIZE = 1 << 16;
+  void write_bytes(const void *src, size_t size);
+  void flush_chunk();
+
+  std::string path_;
+  std::ofstream out_;
+  uint64_t checksum_;
+  char *buffer_;
+  size_t buffer_size_{0};
+  uint32_t chunk_count_{0};
+};
+
+class SnapshotReader {
+ public:
+  // 打开时先把整个文件读一遍，核对 magic、版本、分块结构和 checksum
+  explicit SnapshotReader(const std::string &path);
+  auto is_valid() const -> bool { return valid_; }
+
+  // 下一段是否是 section，且条目由 T... 拼成
+  template <class... T>
+  auto begin_section(SnapshotSection section) -> bool {
+    SnapshotSection tag{};
+    uint32_t entry_size{};
+    read_bytes(&tag, sizeof(tag));
+    read_bytes(&entry_size, sizeof(entry_size));
+    chunk_left_ = 0;
+    return in_.good() && tag == section && entry_size == (sizeof(T) + ...);
+  }
+  // 读这一段的下一个条目，段读完了返回 false
+  template <class... T>
+  auto read(T &...parts) -> bool {
+    if (chunk_left_ == 0) {
+      read_bytes(&chunk_left_, sizeof(chunk_left_));
+      if (!in_.good() || chunk_left_ == 0) {
+        return false;
+      }
+    }
+    (read_bytes(&parts, sizeof(T)), ...);
+    --chunk_left_;
+    return in_.good();
+  }
+
+ private:
+  auto verify() -> bool;
+  void read_bytes(void *dst, size_t size) { in_.read(static_cast<char *>(dst), static_cast<long>(size)); }
+
+  std::ifstream in_;
+  bool valid_{false};
+  uint32_t chunk_left_{0};
+};
+
+/*
+ * 按 B+ 树的批量建树接口把一段条目逐个交出去，不必先把整段读进内存
+ */
+template <class KeyFirst, class KeySecond>
+class SnapshotSource {
+ public:
+  explicit SnapshotSource(SnapshotReader &reader) : reader_(reader) { ++*this; }
+  auto IsEnd() const -> bool { return is_end_; }
+  auto operator*() const -> pair<pair<KeyFirst, KeySecond>, char> { return {entry_, char{}}; }
+  auto operator++() -> SnapshotSource & {
+    is_end_ = !reader_.read(entry_.first, entry_.second);
+    return *this;
+  }
+
+ private:
+  SnapshotReader &reader_;
+  pair<KeyFirst, KeySecond> entry_{};
+  bool is_end_{false};
+};
+
+// 把一棵 B+ 树或一张哈希表的全部条目写成一段
+template <class KeyFirst, class KeySecond, class Index>
+void save_index(SnapshotWriter &writer, SnapshotSection section, Index &index) {
+  writer.begin_section<KeyFirst, KeySecond>(section);
+  index.for_all([&](const KeyFirst &key, const KeySecond &value) { writer.append(key, value); });
+  writer.end_section();
+}
+
+// 清空 tree，再用 section 的条目批量建树
+template <class KeyFirst, class KeySecond, class Tree>
+auto load_tree(SnapshotReader &reader, SnapshotSection section, Tree &tree) -> bool {
+  if (!reader.begin_section<KeyFirst, KeySecond>(section)) {
+    return false;
+  }
+  tree.clear();
+  SnapshotSource<KeyFirst, KeySecond> source{reader};
+  return tree.bulk_load_from(source);
+}
+}  // namespace CrazyDave
+#endif  // TICKETSYSTEM_SNAPSHOT_HPP
@@ -0,0 +1,52 @@
+#ifndef TICKETSYSTEM_STATS_HPP
+#define TICKETSYSTEM_STATS_HPP
+#include <iostream>
+#include "common/utils.hpp"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/extendible_hash_table.h"
+
+namespace CrazyDave {
+inline void print_pool_stats(std::ostream &os, const std::string &name, BufferPoolManager *bpm,
+                             const BufferPoolStats &pool) {
+  os << "pool " << name << " frames " << bpm->GetPoolSize() << " file_pages " << bpm->GetPageCount() << " free_pages "
+     << bpm->GetFreePageCount() << " fetches " << pool.fetches_ << " hits " << pool.hits_ << " misses " << pool.misses_
+     << " evictions " << pool.evictions_ << " dirty_writes " << pool.dirty_writes_ << " prefetches " << pool.prefetches_
+     << " prefetch_hits " << pool.prefetch_hits_ << " flushed_pages " << pool.flushed_pages_ << " flush_batches "
+     << pool.flush_batches_ << " write_stalls " << pool.write_stalls_ << " io_waits " << pool.io_waits_ << "\n";
+}
+
+/**
+ * Prints the shape of a B+ tree and the counters of its buffer pool, one line each:
+ *   index <name> height <h> leaf_pages <n> internal_pages <n> entries <n> fill <f>
+ *   pool <name> frames <n> file_pages <n> free_pages <n> fetches <n> hits <n> misses <n> evictions <n> dirty_writes <n>
+ *        prefetches <n> prefetch_hits <n> flushed_pages <n> flush_batches <n> write_stalls <n> io_waits <n>
+ * Walking the tree touches every page, so this is only meant for the stats command.
+ */
+template <class Tree>
+void print_index_stats(std::ostream &os, Tree &tree) {
+  auto *bpm = tree.GetBufferPoolManager();
+  auto pool = bpm->GetStats();  // copied before the walk below adds its own fetches
+  auto shape = tree.GetTreeStats();
+  double fill = shape.leaf_slots_ == 0 ? 0 : static_cast<double>(shape.entries_) / shape.leaf_slots_;
+  os << "index " << tree.GetName() << " height " << shape.height_ << " leaf_pages " << shape.leaf_pages_
+     << " internal_pages " << shape.internal_pages_ << " entries " << shape.entries_ << " fill " << fill << "\n";
+  print_pool_stats(os, tree.GetName(), bpm, pool);
+}
+
+/**
+ * Same as above for an extendible hash table:
+ *   index <name> global_depth <d> directory_pages <n> bucket_pages <n> entries <n> fill <f>
+ */
+template <class KeyFirst, class KeySecond, class KeyComparator>
+void print_index_stats(std::ostream &os, ExtendibleHashTable<KeyFirst, KeySecond, KeyComparator> &table) {
+  auto *bpm = table.GetBufferPoolManager();
+  auto pool = bpm->GetStats();
+  auto shape = table.GetTableStats();
+  double fill = shape.bucket_slots_ == 0 ? 0 : static_cast<double>(shape.entries_) / shape.bucket_slots_;
+  os << "index " << table.GetName() << " global_depth " << shape.max_global_depth_ << " directory_pages "
+     << shape.directory_pages_ << " bucket_pages " << shape.bucket_pages_ << " entries " << shape.entries_
+     << " fill " << fill << "\n";
+  print_pool_stats(os, table.GetName(), bpm, pool);
+}
+}  // namespace CrazyDave
+#endif  // TICKETSYSTEM_STATS_HPP
@@ -105,14 +105,7 @@ class pair {
   T2 second;
   constexpr pair() : first(), second() {}
   pair(const pair &other) = default;
-  pair &operator=(const pair &other) {
-    if (this == &other) {
-      return *this;
-    }
-    first = other.first;
-    second = other.second;
-    return *this;
-  }
+  pair &operator=(const pair &other) = default;
   pair(pair &&other) noexcept = default;
   pair(const T1 &x, const T2 &y) : first(x), second(y) {}
   template <class U1, class U2>
@@ -149,11 +142,7 @@ class String {
 
   char &operator[](int pos) { return str[pos]; }
 
-  String &operator=(const String &rhs) {
-    if (this == &rhs) return *this;
-    std::strcpy(str, rhs.str);
-    return *this;
-  }
+  String &operator=(const String &rhs) = default;
 
   String &operator=(const char *s) {
     std::strcpy(str, s);
@@ -0,0 +1,378 @@
+/**
+ * bpt_benchmark.cpp
+ * Microbenchmarks for BPlusTree and BufferPoolManager.
+ *
+ * Every workload runs against a fresh on-disk tree and reports wall time together with the buffer pool
+ * counters (page fetches, misses and evictions) divided by the number of operations.
+ *
+ * Usage: bpt_benchmark [-n num_keys] [-p payload_sizes] [-s page_sizes] [-f leaf_formats] [-b pool_sizes]
+ *                      [-k replacer_ks]
+ *   e.g. bpt_benchmark -n 50000 -p 8,404 -s 4096,32768 -f plain,run -b 16,64 -k 5,10
+ * Pool sizes count frames, so a tree with larger pages also gets a larger pool in bytes. Leaf formats are plain and
+ * run, see LeafFormat.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "common/utils.hpp"
+#include "storage/index/b_plus_tree.h"
+
+namespace CrazyDave {
+
+/** A value type of exactly N bytes, ordered by its id. */
+template <size_t N>
+struct Payload {
+  uint32_t id_{};
+  char pad_[N - sizeof(uint32_t)]{};
+  auto operator<(const Payload &rhs) const -> bool { return id_ < rhs.id_; }
+  auto operator!=(const Payload &rhs) const -> bool { return id_ != rhs.id_; }
+};
+
+template <class T>
+auto MakeValue(size_t id) -> T {
+  T value;
+  value.id_ = static_cast<uint32_t>(id);
+  return value;
+}
+
+template <>
+auto MakeValue<size_t>(size_t id) -> size_t {
+  return id;
+}
+
+struct BenchConfig {
+  size_t num_keys_{20000};
+  vector<size_t> payloads_;
+  vector<size_t> page_sizes_;
+  vector<LeafFormat> leaf_formats_;
+  vector<size_t> pool_sizes_;
+  vector<size_t> replacer_ks_;
+};
+
+class BenchTimer {
+ public:
+  BenchTimer() : start_(std::chrono::steady_clock::now()) {}
+  auto ElapsedNs() const -> double {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+const char *const BENCH_FILE = "bpt_bench";
+
+void RemoveBenchFiles() {
+  std::remove((std::string(BENCH_FILE) + "_dt").c_str());
+  std::remove((std::string(BENCH_FILE) + "_cp_dt").c_str());
+}
+
+void PrintHeader() {
+  std::cout << std::left << std::setw(12) << "op" << std::right << std::setw(8) << "payload" << std::setw(6) << "page"
+            << std::setw(6) << "leaf" << std::setw(6) << "pool"
+            << std::setw(4) << "k" << std::setw(10) << "ops" << std::setw(12) << "ns/op" << std::setw(11) << "fetch/op"
+            << std::setw(11) << "miss/op" << std::setw(11) << "evict/op" << "\n";
+}
+
+void Report(const char *op, size_t payload, int page_size, LeafFormat format, size_t pool_size, size_t k, size_t ops,
+            double ns, const BufferPoolStats &stats) {
+  auto per_op = [ops](size_t count) { return static_cast<double>(count) / static_cast<double>(ops); };
+  std::cout << std::left << std::setw(12) << op << std::right << std::setw(8) << payload << std::setw(5)
+            << page_size / 1024 << "K" << std::setw(6) << (format == LeafFormat::RunLength ? "run" : "plain")
+            << std::setw(6) << pool_size
+            << std::setw(4) << k << std::setw(10) << ops << std::fixed << std::setprecision(1) << std::setw(12)
+            << ns / static_cast<double>(ops) << std::setprecision(3) << std::setw(11) << per_op(stats.fetches_)
+            << std::setw(11) << per_op(stats.misses_) << std::setw(11) << per_op(stats.evictions_) << "\n";
+}
+
+/**
+ * Runs all workloads for one (payload, page size, leaf format, pool size, k) combination.
+ */
+template <class V, int PageSize, LeafFormat Format>
+class BPTBenchmark {
+  using Tree = BPT<size_t, V, PageSize, Format>;
+  static constexpr size_t RUN_LENGTH = 32;    // entries sharing one key in the duplicate-key workload
+  static constexpr size_t HOT_KEYS = 16;      // keys looked up before and after the scan in find_hot
+  static constexpr size_t FETCH_ROUNDS = 64;  // passes over the resident pages in fetch_hit
+
+ public:
+  BPTBenchmark(size_t num_keys, size_t pool_size, size_t k) : num_keys_(num_keys), pool_size_(pool_size), k_(k) {
+    for (size_t i = 0; i < num_keys_; ++i) {
+      shuffled_.push_back(i);
+    }
+    std::shuffle(&shuffled_[0], &shuffled_[0] + num_keys_, std::mt19937_64{20240526});
+  }
+
+  void Run() {
+    {
+      auto tree = OpenTree();
+      Measure("insert_seq", tree, num_keys_, [&] {
+        for (size_t i = 0; i < num_keys_; ++i) {
+          tree->insert(i, MakeValue<V>(i));
+        }
+      });
+      Measure("find_point", tree, num_keys_, [&] {
+        vector<V> result;
+        for (size_t i = 0; i < num_keys_; ++i) {
+          tree->find(shuffled_[i], result);
+        }
+      });
+      Measure("scan", tree, num_keys_, [&] { Scan(tree); });
+      // Reopen with an empty pool, load a few leaves spread over the tree, then scan. find_hot measures how many
+      // of them the scan pushed out.
+      tree = ReopenTree(tree);
+      size_t hot_stride = std::max(num_keys_ / HOT_KEYS, static_cast<size_t>(1));
+      vector<V> hot_result;
+      for (size_t i = 0; i < HOT_KEYS; ++i) {
+        tree->find(i * hot_stride, hot_result);
+      }
+      for (auto it = tree->Begin(); !it.IsEnd(); ++it) {
+      }
+      Measure("find_hot", tree, HOT_KEYS, [&] {
+        vector<V> result;
+        for (size_t i = 0; i < HOT_KEYS; ++i) {
+          tree->find(i * hot_stride, result);
+        }
+      });
+      Measure("remove", tree, num_keys_, [&] {
+        for (size_t i = 0; i < num_keys_; ++i) {
+          tree->remove(shuffled_[i], MakeValue<V>(shuffled_[i]));
+        }
+      });
+      CloseTree(tree);
+    }
+    {
+      auto tree = OpenTree();
+      vector<pair<size_t, V>> entries;
+      for (size_t i = 0; i < num_keys_; ++i) {
+        entries.push_back({i, MakeValue<V>(i)});
+      }
+      Measure("bulk_load", tree, num_keys_, [&] { tree->bulk_load(entries); });
+      Scan(tree);
+      CloseTree(tree);
+    }
+    {
+      auto tree = OpenTree();
+      Measure("insert_rand", tree, num_keys_, [&] {
+        for (size_t i = 0; i < num_keys_; ++i) {
+          tree->insert(shuffled_[i], MakeValue<V>(shuffled_[i]));
+        }
+      });
+      // random inserts leave leaves two thirds full and scattered over the file, compare a cold scan before and
+      // after Compact()
+      tree = ReopenTree(tree);
+      Measure("scan_rand", tree, num_keys_, [&] { Scan(tree); });
+      Measure("compact", tree, num_keys_, [&] { tree->Compact(); });
+      Measure("scan_packed", tree, num_keys_, [&] { Scan(tree); });
+      CloseTree(tree);
+    }
+    {
+      auto tree = OpenTree();
+      for (size_t i = 0; i < num_keys_; ++i) {
+        tree->insert(i / RUN_LENGTH, MakeValue<V>(i));
+      }
+      size_t distinct = (num_keys_ + RUN_LENGTH - 1) / RUN_LENGTH;
+      Measure("find_range", tree, distinct, [&] {
+        vector<V> result;
+        for (size_t i = 0; i < num_keys_; ++i) {
+          if (shuffled_[i] < distinct) {
+            result.clear();
+            tree->find(shuffled_[i], result);
+          }
+        }
+      });
+      CloseTree(tree);
+    }
+    {
+      // FetchPage and UnpinPage of pages that are all in the pool, the cost of the page table and the replacer
+      auto tree = OpenTree();
+      auto *bpm = tree->GetBufferPoolManager();
+      vector<page_id_t> pages;
+      page_id_t page_id;
+      for (size_t i = 0; i < pool_size_ / 2; ++i) {
+        bpm->NewPage(&page_id);
+        bpm->UnpinPage(page_id, false);
+        pages.push_back(page_id);
+      }
+      std::shuffle(&pages[0], &pages[0] + pages.size(), std::mt19937_64{20240526});
+      Measure("fetch_hit", tree, pages.size() * FETCH_ROUNDS, [&] {
+        for (size_t r = 0; r < FETCH_ROUNDS; ++r) {
+          for (size_t i = 0; i < pages.size(); ++i) {
+            bpm->FetchPage(pages[i]);
+            bpm->UnpinPage(pages[i], false);
+          }
+        }
+      });
+      for (size_t i = 0; i < pages.size(); ++i) {
+        bpm->DeletePage(pages[i]);
+      }
+      CloseTree(tree);
+    }
+  }
+
+ private:
+  auto OpenTree() -> Tree * {
+    RemoveBenchFiles();
+    return new Tree{BENCH_FILE, 0, pool_size_, k_};
+  }
+
+  auto ReopenTree(Tree *tree) -> Tree * {
+    delete tree;
+    return new Tree{BENCH_FILE, 0, pool_size_, k_};
+  }
+
+  void CloseTree(Tree *tree) {
+    delete tree;
+    RemoveBenchFiles();
+  }
+
+  void Scan(Tree *tree) {
+    size_t cnt = 0;
+    for (auto it = tree->Begin(); !it.IsEnd(); ++it) {
+      ++cnt;
+    }
+    if (cnt != num_keys_) {
+      std::cerr << "scan visited " << cnt << " entries, expected " << num_keys_ << "\n";
+    }
+  }
+
+  template <class Func>
+  void Measure(const char *op, Tree *tree, size_t ops, Func f) {
+    tree->GetBufferPoolManager()->ResetStats();
+    BenchTimer timer;
+    f();
+    auto ns = timer.ElapsedNs();
+    // Compact() replaces the buffer pool, read the counters of the current one
+    Report(op, sizeof(V), PageSize, Format, pool_size_, k_, ops, ns, tree->GetBufferPoolManager()->GetStats());
+  }
+
+  size_t num_keys_;
+  size_t pool_size_;
+  size_t k_;
+  vector<size_t> shuffled_;
+};
+
+template <class V, int PageSize, LeafFormat Format>
+void RunLeafFormat(const BenchConfig &config) {
+  for (size_t i = 0; i < config.pool_sizes_.size(); ++i) {
+    for (size_t j = 0; j < config.replacer_ks_.size(); ++j) {
+      BPTBenchmark<V, PageSize, Format>{config.num_keys_, config.pool_sizes_[i], config.replacer_ks_[j]}.Run();
+    }
+  }
+}
+
+template <class V, int PageSize>
+void RunPageSize(const BenchConfig &config) {
+  for (size_t i = 0; i < config.leaf_formats_.size(); ++i) {
+    if (config.leaf_formats_[i] == LeafFormat::RunLength) {
+      RunLeafFormat<V, PageSize, LeafFormat::RunLength>(config);
+    } else {
+      RunLeafFormat<V, PageSize, LeafFormat::Plain>(config);
+    }
+  }
+}
+
+// The page size of a tree is a template argument, so only these sizes can be picked at run time.
+template <class V>
+void RunPayload(const BenchConfig &config) {
+  for (size_t i = 0; i < config.page_sizes_.size(); ++i) {
+    auto page_size = config.page_sizes_[i];
+    if (page_size == 4096) {
+      RunPageSize<V, 4096>(config);
+    } else if (page_size == 8192) {
+      RunPageSize<V, 8192>(config);
+    } else if (page_size == 12288) {  // BUSTUB_PAGE_SIZE
+      RunPageSize<V, 12288>(config);
+    } else if (page_size == 16384) {
+      RunPageSize<V, 16384>(config);
+    } else if (page_size == 32768) {
+      RunPageSize<V, 32768>(config);
+    } else {
+      std::cerr << "unsupported page size " << page_size << ", choose from 4096, 8192, 12288, 16384, 32768\n";
+    }
+  }
+}
+
+void ParseList(const std::string &value, vector<size_t> &res) {
+  size_t pos = 0;
+  while (pos < value.size()) {
+    auto next = value.find(',', pos);
+    if (next == std::string::npos) {
+      next = value.size();
+    }
+    res.push_back(std::stoul(value.substr(pos, next - pos)));
+    pos = next + 1;
+  }
+}
+
+}  // namespace CrazyDave
+
+auto main(int argc, char **argv) -> int {
+  using namespace CrazyDave;  // NOLINT
+  BenchConfig config;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    std::string value = argv[i + 1];
+    if (key == "-n") {
+      config.num_keys_ = std::stoul(value);
+    } else if (key == "-p") {
+      ParseList(value, config.payloads_);
+    } else if (key == "-s") {
+      ParseList(value, config.page_sizes_);
+    } else if (key == "-f") {
+      size_t pos = 0;
+      while (pos <= value.size()) {
+        auto next = std::min(value.find(',', pos), value.size());
+        auto name = value.substr(pos, next - pos);
+        if (name == "plain") {
+          config.leaf_formats_.push_back(LeafFormat::Plain);
+        } else if (name == "run") {
+          config.leaf_formats_.push_back(LeafFormat::RunLength);
+        } else {
+          std::cerr << "unsupported leaf format " << name << ", choose from plain, run\n";
+        }
+        pos = next + 1;
+      }
+    } else if (key == "-b") {
+      ParseList(value, config.pool_sizes_);
+    } else if (key == "-k") {
+      ParseList(value, config.replacer_ks_);
+    }
+  }
+  if (config.payloads_.empty()) {
+    ParseList("8,64,404", config.payloads_);
+  }
+  if (config.page_sizes_.empty()) {
+    config.page_sizes_.push_back(BUSTUB_PAGE_SIZE);
+  }
+  if (config.leaf_formats_.empty()) {
+    config.leaf_formats_.push_back(LeafFormat::Plain);
+  }
+  if (config.pool_sizes_.empty()) {
+    ParseList("16,64,256", config.pool_sizes_);
+  }
+  if (config.replacer_ks_.empty()) {
+    ParseList("2,5,10", config.replacer_ks_);
+  }
+
+  PrintHeader();
+  for (auto payload : config.payloads_) {
+    if (payload == 8) {
+      RunPayload<size_t>(config);
+    } else if (payload == 64) {
+      RunPayload<Payload<64>>(config);
+    } else if (payload == 128) {
+      RunPayload<Payload<128>>(config);
+    } else if (payload == 404) {  // sizeof(DateInfo)
+      RunPayload<Payload<404>>(config);
+    } else {
+      std::cerr << "unsupported payload size " << payload << ", choose from 8, 64, 128, 404\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,241 @@
+/**
+ * replacer_replay.cpp
+ * Replays buffer pool page access traces under every replacement policy.
+ *
+ * Build with -DBPM_TRACE=ON and run the ticket system; every pool then appends its accesses to <name>_trace.
+ * Each trace is replayed against a simulated pool per policy, and the hit rate together with the time spent per
+ * record is reported. The simulation keeps only the page table, the free list and the replacer: frames are never
+ * pinned between records, and the scan ring of BufferPoolManager is left out, so Scan accesses only reach the
+ * replacer as a hint. An Open record (a new process) empties the pool.
+ *
+ * Usage: replacer_replay [-b pool_sizes] [-k replacer_ks] trace_file...
+ *   e.g. replacer_replay -b 60,200 -k 5,10 se_trace st_trace
+ * Without -b, each trace is replayed at the pool size it was recorded with.
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/utils.hpp"
+#include "data_structures/linked_hashmap.h"
+#include "data_structures/list.h"
+#include "data_structures/vector.h"
+
+namespace CrazyDave {
+
+struct ReplayConfig {
+  vector<size_t> pool_sizes_;
+  vector<size_t> replacer_ks_;
+  vector<std::string> traces_;
+};
+
+struct ReplayResult {
+  size_t records_{0};
+  size_t fetches_{0};
+  size_t hits_{0};
+  size_t prefetches_{0};
+  double ns_{0};
+};
+
+/**
+ * A buffer pool without pages: enough state to tell hits from misses and to drive a replacer.
+ */
+class ReplaySim {
+ public:
+  ReplaySim(ReplacerType replacer_type, size_t pool_size, size_t k)
+      : replacer_type_(replacer_type), pool_size_(pool_size), k_(k), frame_pages_(new page_id_t[pool_size]) {
+    Reset();
+  }
+  ~ReplaySim() {
+    delete replacer_;
+    delete[] frame_pages_;
+  }
+
+  void Replay(const TraceRecord &record, ReplayResult &res) {
+    switch (record.event_) {
+      case TraceEvent::Open:
+        Reset();
+        break;
+      case TraceEvent::Fetch: {
+        ++res.fetches_;
+        auto it = page_table_.find(record.page_id_);
+        if (it != page_table_.end()) {
+          ++res.hits_;
+          replacer_->RecordAccess(it->second, record.page_id_, record.access_type_);
+        } else {
+          Load(record.page_id_, record.access_type_);
+        }
+        break;
+      }
+      case TraceEvent::New:
+        Load(record.page_id_, AccessType::Unknown);
+        break;
+      case TraceEvent::Prefetch:
+        if (page_table_.find(record.page_id_) == page_table_.end()) {
+          ++res.prefetches_;
+          auto fid = AcquireFrame(record.page_id_);
+          replacer_->RecordPrefetch(fid);
+          replacer_->SetEvictable(fid, true);
+        }
+        break;
+      case TraceEvent::Delete: {
+        auto it = page_table_.find(record.page_id_);
+        if (it != page_table_.end()) {
+          replacer_->Remove(it->second);
+          free_list_.push_back(it->second);
+          page_table_.erase(it);
+        }
+        break;
+      }
+    }
+  }
+
+ private:
+  void Reset() {
+    delete replacer_;
+    replacer_ = MakeReplacer(replacer_type_, pool_size_, k_);
+    page_table_.clear();
+    free_list_.clear();
+    for (size_t i = 0; i < pool_size_; ++i) {
+      free_list_.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+
+  auto AcquireFrame(page_id_t page_id) -> frame_id_t {
+    frame_id_t fid;
+    if (!free_list_.empty()) {
+      fid = free_list_.front();
+      free_list_.pop_front();
+    } else {
+      // nothing is pinned here, so the replacer always has a victim
+      replacer_->Evict(&fid);
+      page_table_.erase(page_table_.find(frame_pages_[fid]));
+    }
+    frame_pages_[fid] = page_id;
+    page_table_[page_id] = fid;
+    return fid;
+  }
+
+  void Load(page_id_t page_id, AccessType access_type) {
+    auto fid = AcquireFrame(page_id);
+    replacer_->RecordAccess(fid, page_id, access_type);
+    replacer_->SetEvictable(fid, true);
+  }
+
+  ReplacerType replacer_type_;
+  size_t pool_size_;
+  size_t k_;
+  Replacer *replacer_{nullptr};
+  linked_hashmap<page_id_t, frame_id_t> page_table_;
+  list<frame_id_t> free_list_;
+  /** Page held by each frame, to drop it from page_table_ on eviction. */
+  page_id_t *frame_pages_;
+};
+
+auto LoadTrace(const std::string &file, vector<TraceRecord> &records) -> bool {
+  std::ifstream in{file, std::ios::binary};
+  if (!in) {
+    return false;
+  }
+  TraceRecord record;
+  while (in.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+    records.push_back(record);
+  }
+  return true;
+}
+
+auto RunReplay(const vector<TraceRecord> &records, ReplacerType replacer_type, size_t pool_size, size_t k)
+    -> ReplayResult {
+  ReplayResult res;
+  ReplaySim sim{replacer_type, pool_size, k};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i) {
+    sim.Replay(records[i], res);
+  }
+  res.ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  res.records_ = records.size();
+  return res;
+}
+
+void PrintHeader() {
+  std::cout << std::left << std::setw(16) << "trace" << std::setw(10) << "policy" << std::right << std::setw(6)
+            << "pool" << std::setw(10) << "records" << std::setw(10) << "fetches" << std::setw(10) << "hit_rate"
+            << std::setw(10) << "misses" << std::setw(12) << "prefetches" << std::setw(12) << "ns/record" << "\n";
+}
+
+void Report(const std::string &trace, const std::string &policy, size_t pool_size, const ReplayResult &res) {
+  double hit_rate = res.fetches_ == 0 ? 0 : static_cast<double>(res.hits_) / static_cast<double>(res.fetches_);
+  double ns = res.records_ == 0 ? 0 : res.ns_ / static_cast<double>(res.records_);
+  std::cout << std::left << std::setw(16) << trace << std::setw(10) << policy << std::right << std::setw(6)
+            << pool_size << std::setw(10) << res.records_ << std::setw(10) << res.fetches_ << std::fixed
+            << std::setprecision(4) << std::setw(10) << hit_rate << std::setw(10) << res.fetches_ - res.hits_
+            << std::setw(12) << res.prefetches_ << std::setprecision(1) << std::setw(12) << ns << "\n";
+}
+
+void ReplayTrace(const std::string &file, const ReplayConfig &config) {
+  vector<TraceRecord> records;
+  if (!LoadTrace(file, records) || records.empty()) {
+    std::cerr << "cannot read trace " << file << "\n";
+    return;
+  }
+  vector<size_t> pool_sizes = config.pool_sizes_;
+  if (pool_sizes.empty() && records[0].event_ == TraceEvent::Open) {
+    pool_sizes.push_back(static_cast<size_t>(records[0].page_id_));
+  }
+  for (size_t i = 0; i < pool_sizes.size(); ++i) {
+    auto pool_size = pool_sizes[i];
+    for (size_t j = 0; j < config.replacer_ks_.size(); ++j) {
+      auto k = config.replacer_ks_[j];
+      Report(file, "lru-" + std::to_string(k), pool_size, RunReplay(records, ReplacerType::LRUK, pool_size, k));
+    }
+    Report(file, "clock", pool_size, RunReplay(records, ReplacerType::Clock, pool_size, 0));
+    Report(file, "2q", pool_size, RunReplay(records, ReplacerType::TwoQueue, pool_size, 0));
+    Report(file, "arc", pool_size, RunReplay(records, ReplacerType::ARC, pool_size, 0));
+  }
+}
+
+void ParseList(const std::string &value, vector<size_t> &res) {
+  size_t pos = 0;
+  while (pos < value.size()) {
+    auto next = value.find(',', pos);
+    if (next == std::string::npos) {
+      next = value.size();
+    }
+    res.push_back(std::stoul(value.substr(pos, next - pos)));
+    pos = next + 1;
+  }
+}
+
+}  // namespace CrazyDave
+
+auto main(int argc, char **argv) -> int {
+  using namespace CrazyDave;  // NOLINT
+  ReplayConfig config;
+  for (int i = 1; i < argc; ++i) {
+    std::string key = argv[i];
+    if (key == "-b" && i + 1 < argc) {
+      ParseList(argv[++i], config.pool_sizes_);
+    } else if (key == "-k" && i + 1 < argc) {
+      ParseList(argv[++i], config.replacer_ks_);
+    } else {
+      config.traces_.push_back(key);
+    }
+  }
+  if (config.replacer_ks_.empty()) {
+    ParseList("5,30", config.replacer_ks_);
+  }
+  if (config.traces_.empty()) {
+    std::cerr << "usage: replacer_replay [-b pool_sizes] [-k replacer_ks] trace_file...\n";
+    return 1;
+  }
+
+  PrintHeader();
+  for (size_t i = 0; i < config.traces_.size(); ++i) {
+    ReplayTrace(config.traces_[i], config);
+  }
+  return 0;
+}
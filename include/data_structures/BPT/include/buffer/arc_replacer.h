@@ -0,0 +1,56 @@
+#pragma once
+
+#include "buffer/frame_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "data_structures/linked_hashmap.h"
+
+namespace CrazyDave {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy of Megiddo and Modha.
+ *
+ * T1 holds the pages seen once recently and T2 the pages seen at least twice, both in LRU order. B1 and B2 keep the
+ * ids of the pages recently evicted from T1 and T2. A miss on a page with a ghost in B1 means T1 was too small and
+ * grows the target size p of T1; a ghost hit in B2 shrinks it. Evict() takes the LRU end of T1 while T1 is larger
+ * than p, and the LRU end of T2 otherwise.
+ *
+ * The buffer pool evicts before it knows which page comes next, so the victim is chosen on |T1| and p alone. The
+ * original algorithm also considers whether the missing page has a ghost in B2.
+ */
+class ArcReplacer : public Replacer {
+ public:
+  explicit ArcReplacer(size_t num_frames);
+  ~ArcReplacer() override;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+  void RecordPrefetch(frame_id_t frame_id) override;
+  auto GetVictims(frame_id_t *frames, size_t n) -> size_t override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+  void Remove(frame_id_t frame_id) override;
+  auto Size() -> size_t override;
+
+ private:
+  /** @return the first evictable frame of list that is not cold, -1 if there is none */
+  auto FirstEvictable(const FrameList &list) const -> frame_id_t;
+
+  /** Drop the oldest ghosts so that |T1| + |B1| <= c and |B1| + |B2| <= c. */
+  void TrimGhosts();
+
+  /** Number of frames, c in the paper. */
+  size_t capacity_;
+  /** Target size of T1. */
+  size_t p_{0};
+  size_t curr_size_{0};
+  FrameList t1_;
+  FrameList t2_;
+  linked_hashmap<page_id_t, bool> b1_;
+  linked_hashmap<page_id_t, bool> b2_;
+  page_id_t *page_ids_;
+  bool *evictable_;
+  /** Filled by read-ahead or a scan and not accessed otherwise since. Cold frames wait at the LRU end of T1. */
+  bool *cold_;
+};
+
+}  // namespace CrazyDave
@@ -1,15 +1,70 @@
 #pragma once
 
-#include "buffer/lru_k_replacer.h"
+#include <fstream>
+#include "buffer/epoch_manager.h"
+#include "buffer/free_space_map.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "data_structures/linked_hashmap.h"
 #include "data_structures/list.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/disk/my_disk_manager.h"
 #include "storage/page/page.h"
 #include "storage/page/page_guard.h"
 
 namespace CrazyDave {
 
+/**
+ * Counters of buffer pool activity. They are plain increments on the hot paths and are only read by
+ * benchmarks and diagnostics.
+ */
+struct BufferPoolStats {
+  /** Number of FetchPage calls. */
+  size_t fetches_{0};
+  /** Fetches served from a frame already in the pool. */
+  size_t hits_{0};
+  /** Fetches that had to read the page from disk. */
+  size_t misses_{0};
+  /** Frames taken from the replacer to make room for another page. */
+  size_t evictions_{0};
+  /** Dirty pages written back to disk in the foreground, either on eviction or on deletion. */
+  size_t dirty_writes_{0};
+  /** Evictions that had to write their dirty victim before the frame could be reused. */
+  size_t write_stalls_{0};
+  /** Fetches and evictions that blocked on a background read or write still in flight. */
+  size_t io_waits_{0};
+  /** Dirty pages written by the background flusher. */
+  size_t flushed_pages_{0};
+  /** Runs of adjacent page ids the flushed pages were written in. */
+  size_t flush_batches_{0};
+  /** Number of NewPage calls. */
+  size_t new_pages_{0};
+  /** Number of pages returned to the disk manager. */
+  size_t deleted_pages_{0};
+  /** Read-ahead requests that started a background read. */
+  size_t prefetches_{0};
+  /** Fetches served by a prefetched frame before anything else touched it. */
+  size_t prefetch_hits_{0};
+  /** Pages copied before a write because an open snapshot could still read them. */
+  size_t page_versions_{0};
+  /** Pages deleted while a snapshot was open, freed once the snapshots that could reach them are closed. */
+  size_t retired_pages_{0};
+};
+
+/** Kinds of events in a page access trace. Open marks the start of a process, its page_id_ is the pool size. */
+enum class TraceEvent { Open = 0, Fetch, New, Delete, Prefetch };
+
+/**
+ * One record of the page access trace a pool appends to <name>_trace when BPT_src is built with BPM_TRACE, in the
+ * order the calls were made.
+ */
+struct TraceRecord {
+  TraceEvent event_;
+  AccessType access_type_;
+  page_id_t page_id_;
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -20,9 +75,13 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param replacer_type the replacement policy of this pool
+   * @param page_size size of the pages of the data file in bytes, at least MIN_PAGE_SIZE. A data file must always be
+   * opened with the page size it was created with.
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
    */
-  BufferPoolManager(const std::string &name,size_t pool_size,  size_t replacer_k = LRUK_REPLACER_K);
+  BufferPoolManager(const std::string &name,size_t pool_size,  size_t replacer_k = LRUK_REPLACER_K,
+                    ReplacerType replacer_type = ReplacerType::LRUK, int page_size = BUSTUB_PAGE_SIZE);
 
   /**
    * @brief Destroy an existing BufferPoolManager.
@@ -32,6 +91,9 @@ class BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   [[nodiscard]] auto GetPoolSize() const -> size_t { return pool_size_; }
 
+  /** @brief Return the size of a page in bytes. */
+  [[nodiscard]] auto GetPageSize() const -> int { return page_size_; }
+
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
@@ -42,7 +104,7 @@ class BufferPoolManager {
    * are currently in use and not evictable (in another word, pinned).
    *
    * You should pick the replacement frame from either the free list or the replacer (always find from the free list
-   * first), and then call the AllocatePage() method to get a new page id. If the replacement frame has a dirty page,
+   * first), and then ask the FreeSpaceMap for a new page id. If the replacement frame has a dirty page,
    * you should write it back to the disk first. You also need to reset the memory and metadata for the new page.
    *
    * Remember to "Pin" the frame by calling replacer.SetEvictable(frame_id, false)
@@ -82,10 +144,10 @@ class BufferPoolManager {
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPage().
    *
    * @param page_id id of page to be fetched
-   * @param access_type type of access to the page, only needed for leaderboard tests.
+   * @param access_type type of access to the page. A Scan miss takes its frame from the scan ring, see scan_ring_.
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
-  auto FetchPage(page_id_t page_id) -> Page *;
+  auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
 
   /**
    * TODO(P1): Add implementation
@@ -98,11 +160,50 @@ class BufferPoolManager {
    * the returned page already has a read or write latch held, respectively.
    *
    * @param page_id, the id of the page to fetch
+   * @param access_type type of access to the page, pass AccessType::Scan for pages read once by a whole-index walk
    * @return PageGuard holding the fetched page
    */
-  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
-  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
-  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Hint that page_id will be fetched soon.
+   *
+   * If the page is not in the pool, a frame is taken for it and the read is handed to the disk scheduler, so it runs
+   * in the background while the caller keeps working. The frame stays evictable and enters the replacer with the
+   * oldest history, so read-ahead that is never used is the first thing to go. Does nothing if the page is already
+   * in the pool or too many prefetched frames are still waiting to be used.
+   *
+   * @param page_id id of the page to read ahead, INVALID_PAGE_ID is ignored
+   * @param access_type how the page will be fetched, read-ahead of a scan goes to the scan ring
+   */
+  void PrefetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown);
+
+  /**
+   * @brief Open a snapshot, a read view of every page of the pool as it is now.
+   *
+   * While a snapshot is open, FetchPageWrite() copies a page before the first change an open snapshot could see, and
+   * FetchPageSnapshot() hands the copy to the readers of the snapshots taken before the change. DeletePage() leaves
+   * the page where it is and only retires it. Readers of a snapshot thus see the pages of one moment without holding
+   * back the writers. Pages created through NewPage() are not copied, a snapshot cannot reach them.
+   *
+   * @return the epoch of the snapshot, pass it to FetchPageSnapshot() and EndSnapshot()
+   */
+  auto BeginSnapshot() -> uint64_t;
+
+  /**
+   * @brief Close a snapshot. The page copies and retired pages no open snapshot can reach any more are freed, the
+   * guards fetched through the snapshot must be dropped before.
+   */
+  void EndSnapshot(uint64_t snapshot);
+
+  /**
+   * @brief FetchPageRead() as of an open snapshot.
+   * @return a guard on the copy of the page the snapshot sees, or on the page itself if it has not changed since
+   */
+  auto FetchPageSnapshot(page_id_t page_id, uint64_t snapshot, AccessType access_type = AccessType::Unknown)
+      -> ReadPageGuard;
 
   /**
    * TODO(P1): Add implementation
@@ -147,8 +248,9 @@ class BufferPoolManager {
    * page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
-   * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * back to the free list. Also, reset the page's memory and metadata. Finally, mark the page free in the
+   * FreeSpaceMap, also when it was not in the pool. While a snapshot is open the page is retired instead, and deleted
+   * as above once every snapshot that could read it is closed.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
@@ -157,20 +259,119 @@ class BufferPoolManager {
 
   auto IsNew() -> bool { return disk_manager_->IsNew(); }
 
+  /** @brief Return the activity counters accumulated since construction or the last ResetStats(). */
+  [[nodiscard]] auto GetStats() const -> const BufferPoolStats & { return stats_; }
+
+  /** @brief Clear all activity counters. */
+  void ResetStats() { stats_ = {}; }
+
+  /** @return number of pages the data file spans, including the freed ones */
+  auto GetPageCount() -> size_t { return free_space_map_.GetPageCount(); }
+
+  /** @return number of freed pages waiting to be reused */
+  auto GetFreePageCount() -> size_t { return free_space_map_.GetFreePageCount(); }
+
  private:
+  /**
+   * @brief Take a frame from the free list, or evict one and write it back if it is dirty.
+   *
+   * A Scan access first tries to recycle the frame at the current slot of the scan ring, so that a long scan cycles
+   * through SCAN_RING_SIZE frames instead of evicting the working set.
+   *
+   * @return false if all frames are pinned
+   */
+  auto AcquireFrame(frame_id_t *frame_id, AccessType access_type = AccessType::Unknown) -> bool;
+
+  /** @brief Detach the page held by an unpinned frame that left the replacer, writing it back if it is dirty. */
+  void EvictFrame(frame_id_t frame_id);
+
+  /** @brief Append a record to the access trace, if this pool keeps one. */
+  void Trace(TraceEvent event, page_id_t page_id, AccessType access_type = AccessType::Unknown);
+
+  /** A copy of a page as it was before the writes of epoch_ began. */
+  struct PageVersion {
+    uint64_t epoch_;
+    Page page_;
+    PageVersion *older_;
+  };
+
+  /** @brief Copy data, the current content of page_id, if an open snapshot would see it change otherwise. */
+  void PreserveVersion(page_id_t page_id, const char *data);
+
+  /** A page copy, or a deleted page when version_ is nullptr, kept until the snapshots that could read it close. */
+  struct RetiredPage {
+    page_id_t page_id_;
+    PageVersion *version_;
+  };
+
+  /** @brief Free a retired page copy or delete a retired page. */
+  void Reclaim(const RetiredPage &retired);
+
+  /** @brief Delete page_id right away, see DeletePage(). */
+  auto FreePage(page_id_t page_id) -> bool;
+
+  /** @brief Block until the background read or write of this frame, if any, has completed. */
+  void WaitForFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Keep the next frames to be evicted clean.
+   *
+   * When any of the flush_low_watermark_ coldest evictable frames is dirty, the dirty ones among the
+   * 2 * flush_low_watermark_ coldest frames are handed to the DiskScheduler in page id order, so that adjacent pages
+   * go out as one write. They are marked clean right away and stay evictable, a later FetchPage or eviction of such
+   * a frame waits for its write.
+   */
+  void FlushColdPages();
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
 
+  /** Size of a page in bytes. */
+  const int page_size_;
+
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The memory of all frames, page_size_ bytes each. */
+  char *page_data_;
   /** Pointer to the disk manager. */
   MyDiskManager *disk_manager_;
   /** Page table for keeping track of buffer pool pages. */
-  linked_hashmap<page_id_t, frame_id_t> page_table_;
+  PageTable page_table_;
+  /** Free pages of the data file, kept in pages of the file itself. */
+  FreeSpaceMap free_space_map_{this};
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  Replacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   list<frame_id_t> free_list_;
+  /** Activity counters. */
+  BufferPoolStats stats_;
+  /** Runs the background reads issued by PrefetchPage and the writes issued by FlushColdPages. */
+  DiskScheduler *disk_scheduler_;
+  /** Ticket of the background read or write of each frame, 0 if there is none in flight. */
+  size_t *io_tickets_;
+  /** Whether each frame holds a prefetched page that nobody has fetched yet. */
+  bool *prefetched_;
+  /** Number of frames with prefetched_ set, kept below max_prefetched_. */
+  size_t prefetched_count_{0};
+  size_t max_prefetched_;
+  size_t flush_low_watermark_;
+  /** Scratch space of FlushColdPages(), 2 * flush_low_watermark_ frame ids. */
+  frame_id_t *flush_frames_;
+  /** Frames last handed out to Scan accesses, reused round robin. -1 marks a slot that was never filled. */
+  frame_id_t *scan_ring_;
+  size_t scan_ring_size_;
+  size_t scan_ring_pos_{0};
+  /** Whether each frame still holds a page only scans have asked for, so its ring slot may recycle it. */
+  bool *scan_frames_;
+  /**
+   * Open snapshots and the pages retired for them. The epoch of a write is the current epoch of epochs_, and every
+   * snapshot enters it as a reader. Page copies are retired as soon as they are made.
+   */
+  EpochManager<RetiredPage> epochs_;
+  /** Newest copy of every page copied for a snapshot, linked to the older ones. */
+  linked_hashmap<page_id_t, PageVersion *> versions_;
+  /** Page access trace, only opened when built with BPM_TRACE. */
+  std::ofstream *trace_{nullptr};
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   //  std::mutex latch_;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace CrazyDave {
+
+/**
+ * ClockReplacer implements the CLOCK (second chance) policy.
+ *
+ * The frames sit on a circle swept by a hand. An access sets the reference bit of a frame. Evict() advances the
+ * hand, clearing the reference bits it passes, and takes the first evictable frame whose bit is already clear.
+ * Bookkeeping is a few flags per frame, which makes it the cheapest policy per access.
+ */
+class ClockReplacer : public Replacer {
+ public:
+  explicit ClockReplacer(size_t num_frames);
+  ~ClockReplacer() override;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+  void RecordPrefetch(frame_id_t frame_id) override;
+  auto GetVictims(frame_id_t *frames, size_t n) -> size_t override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+  void Remove(frame_id_t frame_id) override;
+  auto Size() -> size_t override;
+
+ private:
+  size_t num_frames_;
+  size_t hand_{0};
+  size_t curr_size_{0};
+  bool *tracked_;
+  bool *evictable_;
+  bool *referenced_;
+};
+
+}  // namespace CrazyDave
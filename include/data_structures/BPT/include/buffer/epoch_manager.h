@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include "data_structures/list.h"
+
+namespace CrazyDave {
+
+/**
+ * EpochManager holds retired objects until no reader can reach them any more.
+ *
+ * A reader Enter()s the current epoch and Exit()s it when it is done. Enter() also starts the next epoch, so an
+ * object retired after a reader entered is stamped with a later epoch than the reader's. Retire() stamps an object
+ * with the current epoch, and Collect() hands it back once every reader that entered before that epoch has exited.
+ * Objects are retired with ascending stamps, so they are collected in the order they were retired.
+ */
+template <class T>
+class EpochManager {
+ public:
+  /** @return the epoch of the new reader */
+  auto Enter() -> uint64_t {
+    readers_.push_back(epoch_);
+    return epoch_++;
+  }
+
+  void Exit(uint64_t epoch) {
+    for (auto it = readers_.begin(); it != readers_.end(); ++it) {
+      if (*it == epoch) {
+        readers_.erase(it);
+        return;
+      }
+    }
+  }
+
+  /** @return the epoch objects retired now are stamped with */
+  auto GetEpoch() const -> uint64_t { return epoch_; }
+
+  auto HasReaders() const -> bool { return !readers_.empty(); }
+
+  /** @return the epoch of the reader that entered last, there must be one */
+  auto GetNewestReader() const -> uint64_t { return readers_.back(); }
+
+  void Retire(const T &object) { retired_.push_back({epoch_, object}); }
+
+  auto GetRetiredCount() const -> size_t { return retired_.size(); }
+
+  /** Call reclaim(object) for every retired object no reader can reach. */
+  template <class Reclaim>
+  void Collect(Reclaim &&reclaim) {
+    while (!retired_.empty() && (readers_.empty() || retired_.front().epoch_ <= readers_.front())) {
+      auto object = retired_.front().object_;
+      retired_.pop_front();
+      reclaim(object);
+    }
+  }
+
+  /** Call reclaim(object) for every retired object, whether readers are left or not. */
+  template <class Reclaim>
+  void Drain(Reclaim &&reclaim) {
+    while (!retired_.empty()) {
+      auto object = retired_.front().object_;
+      retired_.pop_front();
+      reclaim(object);
+    }
+  }
+
+ private:
+  struct Retired {
+    uint64_t epoch_;
+    T object_;
+  };
+
+  uint64_t epoch_{1};
+  /** Epochs of the readers inside, ascending. */
+  list<uint64_t> readers_;
+  list<Retired> retired_;
+};
+
+}  // namespace CrazyDave
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include "common/config.h"
+
+namespace CrazyDave {
+
+/**
+ * An intrusive doubly linked list over the frame ids of a buffer pool, used by the replacers to keep recency order.
+ * All operations are O(1). Front() is the least recently inserted end.
+ */
+class FrameList {
+ public:
+  explicit FrameList(size_t num_frames)
+      : prev_(new frame_id_t[num_frames]), next_(new frame_id_t[num_frames]), in_list_(new bool[num_frames]{}) {}
+  ~FrameList() {
+    delete[] prev_;
+    delete[] next_;
+    delete[] in_list_;
+  }
+  FrameList(const FrameList &) = delete;
+  auto operator=(const FrameList &) -> FrameList & = delete;
+
+  void PushBack(frame_id_t frame_id) {
+    prev_[frame_id] = tail_;
+    next_[frame_id] = -1;
+    if (tail_ == -1) {
+      head_ = frame_id;
+    } else {
+      next_[tail_] = frame_id;
+    }
+    tail_ = frame_id;
+    in_list_[frame_id] = true;
+    ++size_;
+  }
+
+  void PushFront(frame_id_t frame_id) {
+    prev_[frame_id] = -1;
+    next_[frame_id] = head_;
+    if (head_ == -1) {
+      tail_ = frame_id;
+    } else {
+      prev_[head_] = frame_id;
+    }
+    head_ = frame_id;
+    in_list_[frame_id] = true;
+    ++size_;
+  }
+
+  void Erase(frame_id_t frame_id) {
+    if (prev_[frame_id] == -1) {
+      head_ = next_[frame_id];
+    } else {
+      next_[prev_[frame_id]] = next_[frame_id];
+    }
+    if (next_[frame_id] == -1) {
+      tail_ = prev_[frame_id];
+    } else {
+      prev_[next_[frame_id]] = prev_[frame_id];
+    }
+    in_list_[frame_id] = false;
+    --size_;
+  }
+
+  /** @return the first frame, -1 if the list is empty */
+  auto Front() const -> frame_id_t { return head_; }
+  /** @return the frame after frame_id, -1 at the end */
+  auto Next(frame_id_t frame_id) const -> frame_id_t { return next_[frame_id]; }
+  auto Contains(frame_id_t frame_id) const -> bool { return in_list_[frame_id]; }
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  frame_id_t *prev_;
+  frame_id_t *next_;
+  bool *in_list_;
+  frame_id_t head_{-1};
+  frame_id_t tail_{-1};
+  size_t size_{0};
+};
+
+}  // namespace CrazyDave
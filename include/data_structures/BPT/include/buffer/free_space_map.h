@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include "common/config.h"
+
+namespace CrazyDave {
+
+class BufferPoolManager;
+
+/**
+ * FreeSpaceMap tracks which pages of a data file are free, in pages of that file.
+ *
+ * A meta page keeps the size of the file and one summary bit per bitmap page, and each bitmap page keeps one bit per
+ * page of its range (see free_space_map_page.h). The pages are read and written through the buffer pool like any
+ * other page, so the map is loaded on demand and goes to disk with the pool instead of being rebuilt at startup and
+ * rewritten at exit.
+ *
+ * Freed pages are handed out again lowest id first: the summary and the hint in the meta page lead to the first
+ * bitmap page with a free page, and a single scan of that page finds it.
+ */
+class FreeSpaceMap {
+ public:
+  explicit FreeSpaceMap(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** @brief Format the meta page and the first bitmap page of a new data file. */
+  void Init();
+
+  /** @return a free page id, or a new one at the end of the file if no page is free */
+  auto AllocatePage() -> page_id_t;
+
+  /** @brief Mark page_id as free. Freeing a page twice is a no-op. */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return number of pages the data file spans, including the freed ones and the map itself */
+  auto GetPageCount() -> size_t;
+
+  /** @return number of freed pages waiting to be reused */
+  auto GetFreePageCount() -> size_t;
+
+ private:
+  static auto BitmapPageId(size_t index) -> page_id_t;
+
+  BufferPoolManager *bpm_;
+};
+
+}  // namespace CrazyDave
@@ -1,5 +1,7 @@
+#pragma once
+
+#include "buffer/replacer.h"
 #include "common/config.h"
-#include "data_structures/linked_hashmap.h"
 #include "data_structures/list.h"
 namespace CrazyDave {
 
@@ -16,6 +18,8 @@ class LRUKNode {
   size_t k_{};
   frame_id_t fid_{};
   bool is_evictable_{false};
+  /** Filled by read-ahead or a scan and not accessed otherwise since, history_ holds a single 0. */
+  bool is_cold_{false};
 };
 
 /**
@@ -29,7 +33,7 @@ class LRUKNode {
  * +inf as its backward k-distance. When multipe frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -45,7 +49,10 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override {
+    delete[] node_store_;
+    delete[] victim_ranks_;
+  }
 
   /**
    * TODO(P1): Add implementation
@@ -63,7 +70,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -75,10 +82,30 @@ class LRUKReplacer {
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
    * @param frame_id id of frame that received a new access.
-   * @param access_type type of access that was received. This parameter is only needed for
-   * leaderboard tests.
+   * @param page_id id of the page in the frame, not needed by LRU-K
+   * @param access_type type of access that was received. A Scan access does not count: a new frame gets the oldest
+   * history like a prefetched one, and a frame that already has a history keeps it.
+   */
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+
+  /**
+   * @brief Track a frame that was filled by read-ahead and has not been accessed yet.
+   *
+   * The frame gets the oldest possible history, so it is the first victim among the frames with less than k
+   * accesses and never pushes out pages of the working set. Its first real access in RecordAccess() starts a
+   * fresh history.
+   *
+   * @param frame_id id of the prefetched frame
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordPrefetch(frame_id_t frame_id) override;
+
+  /**
+   * @brief List the frames that the next calls to Evict() would pick, in that order, without evicting them.
+   * @param[out] frames receives at most n frame ids
+   * @param n maximum number of frames to list, no more than num_frames
+   * @return the number of frames listed
+   */
+  auto GetVictims(frame_id_t *frames, size_t n) -> size_t override;
 
   /**
    * TODO(P1): Add implementation
@@ -97,7 +124,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -116,7 +143,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -125,16 +152,22 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
 
  private:
-  linked_hashmap<frame_id_t, LRUKNode> node_store_;
+  /** Drop the history of a node that is no longer tracked. */
+  void Reset(LRUKNode &node);
+
+  /** Node of each frame, indexed by frame id. A frame with an empty history is not tracked. */
+  LRUKNode *node_store_;
   size_t current_timestamp_{0};
   size_t curr_size_{0};
   size_t replacer_size_;
   size_t k_;
   //  std::mutex latch_;
   const size_t inf_ = -1;
+  /** Scratch space of GetVictims(), one rank per listed frame. */
+  size_t *victim_ranks_;
 };
 
 }  // namespace CrazyDave
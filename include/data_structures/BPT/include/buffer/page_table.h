@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "common/config.h"
+
+namespace CrazyDave {
+
+/**
+ * PageTable maps the page ids held by a buffer pool to their frames.
+ *
+ * It is a flat open addressing table with linear probing. The pool never holds more pages than frames, so the
+ * table is sized once to at least twice the pool and never grows. Slots are 8 bytes, so a probe sequence usually
+ * stays within one cache line. Erase() shifts the following entries of the run back instead of leaving tombstones,
+ * which keeps lookups short after many evictions.
+ */
+class PageTable {
+ public:
+  explicit PageTable(size_t num_frames) {
+    while (capacity_ < 2 * num_frames) {
+      capacity_ <<= 1;
+      ++bits_;
+    }
+    mask_ = capacity_ - 1;
+    slots_ = new Slot[capacity_];
+  }
+  ~PageTable() { delete[] slots_; }
+  PageTable(const PageTable &) = delete;
+  auto operator=(const PageTable &) -> PageTable & = delete;
+
+  /** @return the frame holding page_id, -1 if the page is not in the pool */
+  auto Find(page_id_t page_id) const -> frame_id_t {
+    for (auto i = Home(page_id);; i = (i + 1) & mask_) {
+      if (slots_[i].page_id_ == page_id) {
+        return slots_[i].frame_id_;
+      }
+      if (slots_[i].page_id_ == INVALID_PAGE_ID) {
+        return -1;
+      }
+    }
+  }
+
+  /** @brief Map page_id to frame_id, replacing the frame of a page that is already present. */
+  void Insert(page_id_t page_id, frame_id_t frame_id) {
+    auto i = Home(page_id);
+    for (; slots_[i].page_id_ != INVALID_PAGE_ID; i = (i + 1) & mask_) {
+      if (slots_[i].page_id_ == page_id) {
+        slots_[i].frame_id_ = frame_id;
+        return;
+      }
+    }
+    slots_[i] = {page_id, frame_id};
+    ++size_;
+  }
+
+  /** @return false if page_id was not present */
+  auto Erase(page_id_t page_id) -> bool {
+    auto i = Home(page_id);
+    for (; slots_[i].page_id_ != page_id; i = (i + 1) & mask_) {
+      if (slots_[i].page_id_ == INVALID_PAGE_ID) {
+        return false;
+      }
+    }
+    // Move back every later entry of the run whose home slot does not lie in (i, j], so no probe sequence crosses
+    // the hole.
+    for (auto j = (i + 1) & mask_; slots_[j].page_id_ != INVALID_PAGE_ID; j = (j + 1) & mask_) {
+      auto home = Home(slots_[j].page_id_);
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].page_id_ = INVALID_PAGE_ID;
+    --size_;
+    return true;
+  }
+
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  struct Slot {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    frame_id_t frame_id_{-1};
+  };
+
+  /** Page ids are allocated sequentially, Fibonacci hashing spreads them over the table. */
+  auto Home(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               (64 - bits_)) &
+           mask_;
+  }
+
+  size_t capacity_{2};
+  size_t bits_{1};
+  size_t mask_;
+  size_t size_{0};
+  Slot *slots_;
+};
+
+}  // namespace CrazyDave
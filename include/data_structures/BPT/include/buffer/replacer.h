@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include "common/config.h"
+
+namespace CrazyDave {
+
+/**
+ * How a page is being accessed. Scan accesses touch pages once and must not push the working set out of the pool.
+ */
+enum class AccessType { Unknown = 0, Lookup, Scan, Index };
+
+/** Replacement policies a BufferPoolManager can be built with. */
+enum class ReplacerType { LRUK = 0, Clock, TwoQueue, ARC };
+
+/**
+ * Replacer tracks the frames of a buffer pool and picks the victim when a frame has to be reused.
+ *
+ * Only frames marked evictable are candidates. A frame enters the replacer on its first RecordAccess() or
+ * RecordPrefetch() and leaves it on Evict() or Remove().
+ */
+class Replacer {
+ public:
+  virtual ~Replacer() = default;
+
+  /**
+   * @brief Pick a victim among the evictable frames and stop tracking it.
+   * @param[out] frame_id id of the evicted frame
+   * @return false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Record that the page page_id held by frame_id was accessed.
+   *
+   * A Scan access does not count as a reference: a new frame is tracked like a prefetched one, and a frame that is
+   * already tracked keeps its position.
+   */
+  virtual void RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) = 0;
+
+  /**
+   * @brief Track a frame that was filled by read-ahead and has not been accessed yet. It is the first victim until
+   * its first real access, which admits it like a newly read page.
+   */
+  virtual void RecordPrefetch(frame_id_t frame_id) = 0;
+
+  /**
+   * @brief List the frames that the next calls to Evict() are expected to pick, in that order, without evicting them.
+   * @param[out] frames receives at most n frame ids
+   * @return the number of frames listed
+   */
+  virtual auto GetVictims(frame_id_t *frames, size_t n) -> size_t = 0;
+
+  /** @brief Toggle whether a tracked frame may be evicted. Size() counts the evictable frames. */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /** @brief Stop tracking an evictable frame whose page was deleted, without treating it as evicted. */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+};
+
+/**
+ * @brief Create a replacer of the given policy for num_frames frames.
+ * @param k the lookback constant, only used by LRU-K
+ */
+auto MakeReplacer(ReplacerType replacer_type, size_t num_frames, size_t k) -> Replacer *;
+
+}  // namespace CrazyDave
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "buffer/frame_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "data_structures/linked_hashmap.h"
+
+namespace CrazyDave {
+
+/**
+ * TwoQueueReplacer implements the full 2Q policy of Johnson and Shasha.
+ *
+ * A page read for the first time enters A1in, a FIFO queue. Further accesses while it is in A1in do not promote it,
+ * so a burst of correlated references counts once. Pages evicted from A1in leave their page id in A1out, a FIFO of
+ * ghosts. A page read again while its ghost is in A1out is hot and goes to Am, an LRU list. Evict() takes from A1in
+ * while it holds more than a quarter of the frames, and from the LRU end of Am otherwise. A1out remembers up to half
+ * as many pages as there are frames.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  explicit TwoQueueReplacer(size_t num_frames);
+  ~TwoQueueReplacer() override;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+  void RecordPrefetch(frame_id_t frame_id) override;
+  auto GetVictims(frame_id_t *frames, size_t n) -> size_t override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+  void Remove(frame_id_t frame_id) override;
+  auto Size() -> size_t override;
+
+ private:
+  /** @return the first evictable frame of list that is not cold, -1 if there is none */
+  auto FirstEvictable(const FrameList &list) const -> frame_id_t;
+
+  /** Maximum size of A1in before Evict() prefers it over Am. */
+  size_t kin_;
+  /** Maximum number of ghosts in A1out. */
+  size_t kout_;
+  size_t curr_size_{0};
+  FrameList a1in_;
+  FrameList am_;
+  linked_hashmap<page_id_t, bool> a1out_;
+  page_id_t *page_ids_;
+  bool *evictable_;
+  /** Filled by read-ahead or a scan and not accessed otherwise since. Cold frames wait at the front of A1in. */
+  bool *cold_;
+};
+
+}  // namespace CrazyDave
@@ -5,8 +5,12 @@
 namespace CrazyDave {
 
 static constexpr int INVALID_PAGE_ID = -1;     // invalid page id
-static constexpr int BUSTUB_PAGE_SIZE = 12288;  // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = 12288;  // default size of a data page in byte, a tree may pick its own
+static constexpr int MIN_PAGE_SIZE = 4096;      // smallest page size a buffer pool accepts
 static constexpr int LRUK_REPLACER_K = 10;     // lookback window for lru-k replacer
+static constexpr int READ_AHEAD_PAGES = 4;     // max sibling leaves prefetched by a B+ tree scan
+static constexpr int FLUSH_WATERMARK_DIV = 8;  // keep pool_size / 8 clean frames at the cold end of the pool
+static constexpr int SCAN_RING_SIZE = 4;       // frames a scan recycles instead of evicting the working set
 
 using frame_id_t = int32_t;  // frame id type
 using page_id_t = int32_t;   // page id type
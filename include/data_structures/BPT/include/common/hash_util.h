@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CrazyDave {
+
+/** 64-bit finalizer of MurmurHash3, spreads the weak string hashes used as keys over all bits. */
+inline auto HashKey(uint64_t key) -> uint64_t {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+/** Composite keys such as pair<size_t, int> are hashed field by field. */
+template <class T>
+auto HashKey(const T &key) -> decltype(key.first, key.second, uint64_t()) {
+  return HashKey(HashKey(key.first) ^ (HashKey(key.second) * 0x9e3779b97f4a7c15ULL));
+}
+
+}  // namespace CrazyDave
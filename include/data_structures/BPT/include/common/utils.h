@@ -2,6 +2,7 @@
 #define BPT_PRO_UTILS_H
 #include <cstring>
 #include <string>
+#include "common/utils.hpp"
 namespace CrazyDave {
 
 template <class KeyFirst, class KeySecond, class ValueType>
@@ -36,6 +37,16 @@ class Comparator {
     }
     return 0;
   }
+  // for leaves that keep the first key once per run, see BPlusTreeRunLeafPage
+  auto CompareSecond(const KeySecond &s1, const KeySecond &s2) const -> int {
+    if (s1 < s2) {
+      return -1;
+    }
+    if (s2 < s1) {
+      return 1;
+    }
+    return 0;
+  }
 };
 
 }  // namespace CrazyDave
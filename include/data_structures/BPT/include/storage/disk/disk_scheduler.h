@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "common/config.h"
+#include "data_structures/list.h"
+#include "storage/disk/my_disk_manager.h"
+
+namespace CrazyDave {
+
+/**
+ * @brief Represents a Read or Write request for the DiskManager to execute.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+
+  /**
+   *  Pointer to the start of the memory location where a page is either:
+   *   1. being read into from disk (on a read).
+   *   2. being written out to disk (on a write).
+   */
+  char *data_;
+
+  /** ID of the page being read from / written to disk. */
+  page_id_t page_id_;
+};
+
+/**
+ * @brief The DiskScheduler runs disk requests on a background worker thread, so that the buffer pool can start a
+ * read before the page is needed.
+ *
+ * Requests are served in the order they were scheduled. Schedule() returns a ticket, and Wait(ticket) blocks until
+ * that request and every request before it has completed. Writes of consecutive page ids that are queued back to
+ * back are issued as one sequential write of up to MAX_WRITE_BATCH pages.
+ */
+class DiskScheduler {
+ public:
+  explicit DiskScheduler(MyDiskManager *disk_manager);
+  ~DiskScheduler();
+
+  /**
+   * @brief Queue a request for the worker thread.
+   * @return the ticket of the request, always greater than 0
+   */
+  auto Schedule(const DiskRequest &r) -> size_t;
+
+  /**
+   * @brief Block until the request with this ticket has completed.
+   */
+  void Wait(size_t ticket);
+
+  /** @return whether the request with this ticket has completed, without blocking */
+  auto IsDone(size_t ticket) -> bool;
+
+ private:
+  static constexpr int MAX_WRITE_BATCH = 16;
+
+  void StartWorkerThread();
+
+  MyDiskManager *disk_manager_;
+  std::mutex latch_;
+  std::condition_variable request_cv_;
+  std::condition_variable done_cv_;
+  list<DiskRequest> requests_;
+  size_t scheduled_{0};
+  size_t completed_{0};
+  bool stop_{false};
+  std::thread background_thread_;
+};
+
+}  // namespace CrazyDave
@@ -27,9 +27,9 @@ class MyFile {
 
   ~MyFile() { fs_.close(); }
 
-  void SetReadPointer(int offset) { fs_.seekg(offset); }
+  void SetReadPointer(std::streamoff offset) { fs_.seekg(offset); }
 
-  void SetWritePointer(int offset) { fs_.seekp(offset); }
+  void SetWritePointer(std::streamoff offset) { fs_.seekp(offset); }
 
   void Read(char *data, int size) {
     fs_.read(data, size);
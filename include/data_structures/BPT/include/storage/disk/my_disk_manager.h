@@ -2,6 +2,7 @@
 #define BPT_PRO_DISK_MANAGER_H
 
 #include <fstream>
+#include <mutex>
 #include <string>
 #include "common/config.h"
 #include "file_wrapper.h"
@@ -9,65 +10,38 @@ namespace CrazyDave {
 
 class MyDiskManager {
  public:
-  explicit MyDiskManager(const std::string &name) {
-    garbage_file = new MyFile(name + "_gb");
+  explicit MyDiskManager(const std::string &name, int page_size = BUSTUB_PAGE_SIZE) : page_size_(page_size) {
     data_file_ = new MyFile(name + "_dt");
-    if (!garbage_file->IsNew()) {
-      garbage_file->SetReadPointer(0);
-      size_t size;
-      garbage_file->ReadObj(size);
-      page_id_t max_page_id;
-      garbage_file->ReadObj(max_page_id);
-      max_page_id_ = max_page_id;
-      for (size_t i = 0; i < size; ++i) {
-        page_id_t page_id;
-        garbage_file->ReadObj(page_id);
-        queue_.push_back(page_id);
-      }
-    }
-  }
-  ~MyDiskManager() {
-    garbage_file->SetWritePointer(0);
-    size_t size = queue_.size();
-    garbage_file->WriteObj(size);
-
-    garbage_file->WriteObj(max_page_id_);
-    for (size_t i = 0; i < size; ++i) {
-      page_id_t page_id = queue_.back();
-      queue_.pop_back();
-      garbage_file->WriteObj(page_id);
-    }
-    delete garbage_file;
-    delete data_file_;
   }
+  ~MyDiskManager() { delete data_file_; }
+  // ReadPage and WritePage are also called from the DiskScheduler worker, io_latch_ keeps the stream consistent.
   void WritePage(page_id_t page_id, const char *page_data) {
-    int offset = page_id * BUSTUB_PAGE_SIZE;
-    data_file_->SetWritePointer(offset);
-    data_file_->Write(page_data, BUSTUB_PAGE_SIZE);
-  }
-  void ReadPage(page_id_t page_id, char *page_data) {
-    int offset = page_id * BUSTUB_PAGE_SIZE;
-    data_file_->SetReadPointer(offset);
-    data_file_->Read(page_data, BUSTUB_PAGE_SIZE);
+    std::lock_guard<std::mutex> lock(io_latch_);
+    data_file_->SetWritePointer(Offset(page_id));
+    data_file_->Write(page_data, page_size_);
   }
-  auto AllocatePage() -> page_id_t {
-    if (!queue_.empty()) {
-      auto page_id = queue_.front();
-      queue_.pop_front();
-      return page_id;
+  // Write count pages with consecutive ids starting at page_id, with a single seek.
+  void WritePages(page_id_t page_id, char *const *pages, int count) {
+    std::lock_guard<std::mutex> lock(io_latch_);
+    data_file_->SetWritePointer(Offset(page_id));
+    for (int i = 0; i < count; ++i) {
+      data_file_->Write(pages[i], page_size_);
     }
-    return ++max_page_id_;
   }
-
-  void DeallocatePage(page_id_t page_id) { queue_.push_back(page_id); }
-  auto IsNew() -> bool { return garbage_file->IsNew(); }
+  void ReadPage(page_id_t page_id, char *page_data) {
+    std::lock_guard<std::mutex> lock(io_latch_);
+    data_file_->SetReadPointer(Offset(page_id));
+    data_file_->Read(page_data, page_size_);
+  }
+  auto IsNew() -> bool { return data_file_->IsNew(); }
+  auto GetPageSize() const -> int { return page_size_; }
 
  private:
-  MyFile *data_file_{nullptr};
-  MyFile *garbage_file{nullptr};  // 第一位size_，第二位max_page_id_
+  auto Offset(page_id_t page_id) const -> std::streamoff { return static_cast<std::streamoff>(page_id) * page_size_; }
 
-  list<page_id_t> queue_{};
-  page_id_t max_page_id_{0};
+  int page_size_;
+  MyFile *data_file_{nullptr};
+  std::mutex io_latch_;
 };
 }  // namespace CrazyDave
 #endif  // BPT_PRO_DISK_MANAGER_H
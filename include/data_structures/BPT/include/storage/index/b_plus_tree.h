@@ -1,16 +1,21 @@
 #pragma once
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include "common/config.h"
 #include "common/utils.h"
 #include "data_structures/list.h"
 #include "data_structures/vector.h"
+#include "storage/index/bloom_filter.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_header_page.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_run_leaf_page.h"
 #include "storage/page/page_guard.h"
 
 namespace CrazyDave {
@@ -44,34 +49,84 @@ class Context {
   [[nodiscard]] auto IsRootPage(page_id_t page_id) const -> bool { return page_id == root_page_id_; }
 };
 
-#define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+#define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator, PageSize, Format>
+
+/**
+ * Shape of a B+ tree, gathered by visiting every page of it.
+ */
+struct BPlusTreeStats {
+  int height_{0};
+  size_t leaf_pages_{0};
+  size_t internal_pages_{0};
+  size_t entries_{0};
+  // Sum of the max sizes of all leaf pages, entries_ / leaf_slots_ is the leaf fill factor.
+  size_t leaf_slots_{0};
+};
 
 // Main class providing the API for the Interactive B+ Tree.
-template <typename KeyFirst, typename KeySecond, typename ValueType, typename KeyComparator>
+// PageSize is the page size of this tree's data file, the fanout of its pages follows from it at compile time.
+// Format picks the leaf page layout. LeafFormat::RunLength suits trees with many values per first key, it needs an
+// integral KeyFirst and a KeyComparator with CompareSecond().
+template <typename KeyFirst, typename KeySecond, typename ValueType, typename KeyComparator,
+          int PageSize = BUSTUB_PAGE_SIZE, LeafFormat Format = LeafFormat::Plain>
 class BPlusTree {
   using KeyType = pair<KeyFirst, KeySecond>;
-  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
-  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator, PageSize>;
+  using LeafPage = std::conditional_t<Format == LeafFormat::RunLength,
+                                      BPlusTreeRunLeafPage<KeyType, ValueType, KeyComparator, PageSize>,
+                                      BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, PageSize>>;
   enum class Protocol { Optimistic, Pessimistic };
+  static_assert(PageSize >= MIN_PAGE_SIZE, "the buffer pool does not take pages this small");
+  static_assert(LeafPage::LEAF_PAGE_SIZE >= 4 && InternalPage::INTERNAL_PAGE_SIZE >= 4,
+                "a page must hold a few entries to split and merge");
 
  public:
   explicit BPlusTree(std::string name, page_id_t header_page_id, size_t pool_size, size_t replacer_k,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE)
+                     ReplacerType replacer_type = ReplacerType::LRUK,
+                     int leaf_max_size = LeafPage::LEAF_PAGE_SIZE,
+                     int internal_max_size = InternalPage::INTERNAL_PAGE_SIZE)
       : index_name_(std::move(name)),
+        pool_size_(pool_size),
+        replacer_k_(replacer_k),
+        replacer_type_(replacer_type),
         leaf_max_size_(leaf_max_size),
         internal_max_size_(internal_max_size),
         header_page_id_(header_page_id) {
     //  std::cout << "Hello from asshole debugger CrazyDave.\nConstructing BPlusTree.\nleaf_max_size: " <<
     //  leaf_max_size_
     //            << ", internal_max_size: " << internal_max_size_ << "\n";  // debug
-    bpm_ = new BufferPoolManager{index_name_, pool_size, replacer_k};
+    bpm_ = new BufferPoolManager{index_name_, pool_size, replacer_k, replacer_type, PageSize};
     if (bpm_->IsNew()) {
       WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
       auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
       root_page->root_page_id_ = INVALID_PAGE_ID;
     }
   }
-  ~BPlusTree() { delete bpm_; }
+  ~BPlusTree() {
+    if (bloom_filter_ != nullptr) {
+      bloom_filter_->Save(*bloom_file_);
+      delete bloom_filter_;
+      delete bloom_file_;
+    }
+    delete bpm_;
+  }
+
+  /**
+   * Attach a Bloom filter over the first key component, so that find() on a key that was never inserted
+   * returns without descending the tree. The filter is kept in <name>_bf next to the data file, and rebuilt
+   * from a full scan when that file is missing or was not written on a clean shutdown.
+   */
+  void EnableBloomFilter() {
+    if (bloom_filter_ != nullptr) {
+      return;
+    }
+    bloom_filter_ = new BloomFilter;
+    bloom_file_ = new MyFile{index_name_ + "_bf"};
+    if (bloom_file_->IsNew() || !bloom_filter_->Load(*bloom_file_)) {
+      RebuildBloomFilter();
+    }
+    BloomFilter::MarkDirty(*bloom_file_);
+  }
 
   // Returns true if this B+ tree has no keys and values.
   [[nodiscard]] auto IsEmpty() const -> bool {
@@ -80,21 +135,137 @@ class BPlusTree {
     return root_page->root_page_id_ == INVALID_PAGE_ID;
   }
 
-  void insert(const KeyFirst &key, const KeySecond &value) { insert({key, value}, {}); }
+  void insert(const KeyFirst &key, const KeySecond &value) {
+    if (insert({key, value}, {}).first && bloom_filter_ != nullptr) {
+      auto hash = HashKey(key);
+      if (bloom_filter_->MayContain(hash)) {
+        return;
+      }
+      if (bloom_filter_->GetInsertCount() < bloom_filter_->GetCapacity()) {
+        bloom_filter_->Insert(hash);
+      } else {
+        RebuildBloomFilter();
+      }
+    }
+  }
 
   void remove(const KeyFirst &key, const KeySecond &value) { remove({key, value}); }
 
+  /**
+   * A read view of the tree as it was when GetSnapshot() returned, see BufferPoolManager::BeginSnapshot(). Inserts
+   * and removes made while it is open do not show through it, so a long read can run against one consistent state
+   * of the tree while writes go on. It must be closed, i.e. destroyed, before the tree is compacted or destroyed.
+   */
+  class Snapshot {
+   public:
+    explicit Snapshot(BufferPoolManager *bpm) : bpm_(bpm), epoch_(bpm->BeginSnapshot()) {}
+    Snapshot(const Snapshot &) = delete;
+    auto operator=(const Snapshot &) -> Snapshot & = delete;
+    ~Snapshot() { bpm_->EndSnapshot(epoch_); }
+
+    auto GetEpoch() const -> uint64_t { return epoch_; }
+
+   private:
+    BufferPoolManager *bpm_;
+    uint64_t epoch_;
+  };
+
+  auto GetSnapshot() -> Snapshot { return Snapshot{bpm_}; }
+
+  /**
+   * Call visitor(value) with a const reference into the pinned leaf for every value stored under key, in
+   * ascending order. The visitor returns false to stop early.
+   */
+  template <class Visitor>
+  void for_each(const KeyFirst &key, Visitor &&visitor) {
+    if (bloom_filter_ != nullptr && !bloom_filter_->MayContain(HashKey(key))) {
+      return;
+    }
+    ForEach(key, visitor, nullptr);
+  }
+
+  // Same as above, as of snapshot. The Bloom filter is skipped, it may have dropped keys removed since.
+  template <class Visitor>
+  void for_each(const KeyFirst &key, Visitor &&visitor, const Snapshot &snapshot) {
+    ForEach(key, visitor, &snapshot);
+  }
+
+  // Copy the smallest value stored under key into out. Return false if there is none
+  auto find_first(const KeyFirst &key, KeySecond &out) -> bool {
+    bool found = false;
+    for_each(key, [&](const KeySecond &value) {
+      out = value;
+      found = true;
+      return false;
+    });
+    return found;
+  }
+
   // Return the value associated with a given key
   void find(const KeyFirst &key, vector<KeySecond> &result) {
-    auto header_page_guard = bpm_->FetchPageRead(header_page_id_);
-    auto header_page = header_page_guard.As<BPlusTreeHeaderPage>();
-    if (header_page->root_page_id_ == INVALID_PAGE_ID) {
-      header_page_guard.Drop();
+    for_each(key, [&](const KeySecond &value) {
+      result.push_back(value);
+      return true;
+    });
+  }
+
+  void find(const KeyFirst &key, vector<KeySecond> &result, const Snapshot &snapshot) {
+    for_each(
+        key,
+        [&](const KeySecond &value) {
+          result.push_back(value);
+          return true;
+        },
+        snapshot);
+  }
+
+  /**
+   * Look up many first keys with a single descent. The keys are visited in ascending order, the pages on the
+   * path to the current leaf stay pinned, and only the levels below the first page where the next key takes
+   * a different child are fetched again.
+   * callback(i, value) is called for every value stored under keys[i], the values of one key in ascending order.
+   */
+  template <class Callback>
+  void find_batch(const vector<KeyFirst> &keys, Callback &&callback) {
+    vector<pair<KeyFirst, size_t>> order;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (bloom_filter_ == nullptr || bloom_filter_->MayContain(HashKey(keys[i]))) {
+        order.push_back({keys[i], i});
+      }
+    }
+    auto root_page_id = GetRootPageId();
+    if (order.empty() || root_page_id == INVALID_PAGE_ID) {
       return;
     }
-    auto guard = bpm_->FetchPageRead(header_page->root_page_id_);
-    header_page_guard.Drop();
-    find({key, {}}, result, guard);
+    order.sort([](const pair<KeyFirst, size_t> &lhs, const pair<KeyFirst, size_t> &rhs) { return lhs < rhs; });
+
+    ReadPageGuard path[MAX_HEIGHT];  // path[0] is the root, path[height - 1] the current leaf
+    int child[MAX_HEIGHT];           // child[i] is the slot of path[i + 1] in path[i]
+    path[0] = bpm_->FetchPageRead(root_page_id);
+    int height = 1;
+    for (size_t k = 0; k < order.size(); ++k) {
+      KeyType key{order[k].first, {}};
+      int level = 0;
+      while (level + 1 < height &&
+             path[level].template As<InternalPage>()->LowerBoundByFirst(key, comparator_) - 1 == child[level]) {
+        ++level;
+      }
+      auto *bpt_page = path[level].template As<BPlusTreePage>();
+      while (!bpt_page->IsLeafPage()) {
+        auto internal_page = reinterpret_cast<const InternalPage *>(bpt_page);
+        child[level] = internal_page->LowerBoundByFirst(key, comparator_) - 1;
+        path[level + 1] = bpm_->FetchPageRead(internal_page->ValueAt(child[level]));
+        bpt_page = path[++level].template As<BPlusTreePage>();
+      }
+      height = level + 1;
+
+      ReadPageGuard next_guard;  // the leaf in path[] stays pinned for the next key
+      auto visitor = [&](const KeySecond &value) {
+        callback(order[k].second, value);
+        return true;
+      };
+      ScanLeafChain(key, reinterpret_cast<const LeafPage *>(bpt_page), next_guard, visitor);
+    }
   }
 
   // Return the page id of the root node
@@ -104,6 +275,135 @@ class BPlusTree {
     return header_page->root_page_id_;
   }
 
+  // Return the buffer pool backing this tree, e.g. to read its activity counters
+  auto GetBufferPoolManager() -> BufferPoolManager * { return bpm_; }
+
+  auto GetName() const -> const std::string & { return index_name_; }
+
+  // Walk the tree level by level and count its pages and entries. Touches every page, so keep it off hot paths.
+  auto GetTreeStats() -> BPlusTreeStats {
+    BPlusTreeStats stats;
+    vector<page_id_t> pages;
+    auto root_page_id = GetRootPageId();
+    if (root_page_id == INVALID_PAGE_ID) {
+      return stats;
+    }
+    pages.push_back(root_page_id);
+    size_t level_begin = 0;
+    while (level_begin < pages.size()) {
+      size_t level_end = pages.size();
+      ++stats.height_;
+      for (size_t i = level_begin; i < level_end; ++i) {
+        auto guard = bpm_->FetchPageRead(pages[i], AccessType::Scan);
+        auto bpt_page = guard.As<BPlusTreePage>();
+        if (bpt_page->IsLeafPage()) {
+          ++stats.leaf_pages_;
+          stats.entries_ += bpt_page->GetSize();
+          stats.leaf_slots_ += bpt_page->GetMaxSize();
+          continue;
+        }
+        ++stats.internal_pages_;
+        auto internal_page = reinterpret_cast<const InternalPage *>(bpt_page);
+        for (int j = 0; j < internal_page->GetSize(); ++j) {
+          pages.push_back(internal_page->ValueAt(j));
+        }
+      }
+      level_begin = level_end;
+    }
+    return stats;
+  }
+
+  /**
+   * Rebuild the tree into a fresh file and swap it in for the data file. Leaves are filled to fill_factor of their
+   * capacity and laid out in key order ahead of the internal pages, so a scan reads the file front to back and the
+   * freed pages of the old file are gone. The new file is written as <name>_cp_dt and renamed over <name>_dt, so a
+   * crash leaves either the old or the new tree. No iterator or page guard of this tree may be alive, and the
+   * buffer pool starts out empty afterwards.
+   * @return false if the new file could not be renamed over the old one
+   */
+  auto Compact(double fill_factor = PACK_FILL_FACTOR) -> bool {
+    std::string packed_name = index_name_ + "_cp";
+    std::remove((packed_name + "_dt").c_str());
+    auto *packed_bpm = new BufferPoolManager{packed_name, pool_size_, replacer_k_, replacer_type_, PageSize};
+    page_id_t root_page_id;
+    {
+      auto it = Begin();  // must release its leaf before the pool goes away
+      root_page_id = BuildPacked(packed_bpm, fill_factor, it);
+    }
+    packed_bpm->FetchPageWrite(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    delete packed_bpm;
+    delete bpm_;
+    bool renamed = std::rename((packed_name + "_dt").c_str(), (index_name_ + "_dt").c_str()) == 0;
+    bpm_ = new BufferPoolManager{index_name_, pool_size_, replacer_k_, replacer_type_, PageSize};
+    insert_hint_.page_id_ = INVALID_PAGE_ID;
+    return renamed;
+  }
+
+  /**
+   * Insert entries, which must be sorted ascending and free of duplicates. An empty tree is built directly,
+   * leaves left to right at fill_factor and internal levels bottom up, without a single split. Otherwise the
+   * entries are inserted one by one, and the sorted order lets most of them take the InsertAtHint() path.
+   */
+  void bulk_load(const vector<pair<KeyFirst, KeySecond>> &entries, double fill_factor = PACK_FILL_FACTOR) {
+    if (entries.empty()) {
+      return;
+    }
+    if (!IsEmpty()) {
+      for (size_t i = 0; i < entries.size(); ++i) {
+        insert(entries[i].first, entries[i].second);
+      }
+      return;
+    }
+    EntryRange range{&entries[0], &entries[0] + entries.size()};
+    auto root_page_id = BuildPacked(bpm_, fill_factor, range);
+    bpm_->FetchPageWrite(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    insert_hint_.page_id_ = INVALID_PAGE_ID;
+    if (bloom_filter_ != nullptr) {
+      RebuildBloomFilter();
+    }
+  }
+
+  /**
+   * Build an empty tree like bulk_load() does, streaming the entries from source instead of holding them in memory.
+   * source has IsEnd(), operator++() and an operator*() yielding pair<pair<KeyFirst, KeySecond>, ValueType>, runs
+   * over sorted entries free of duplicates and is left at its end.
+   * @return false if the tree is not empty
+   */
+  template <class Source>
+  auto bulk_load_from(Source &source, double fill_factor = PACK_FILL_FACTOR) -> bool {
+    if (!IsEmpty()) {
+      return false;
+    }
+    auto root_page_id = BuildPacked(bpm_, fill_factor, source);
+    bpm_->FetchPageWrite(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    insert_hint_.page_id_ = INVALID_PAGE_ID;
+    if (bloom_filter_ != nullptr) {
+      RebuildBloomFilter();
+    }
+    return true;
+  }
+
+  /** Call visitor(key, value) for every pair in ascending order, reading the leaves front to back. */
+  template <class Visitor>
+  void for_all(Visitor &&visitor) {
+    for (auto it = Begin(); !it.IsEnd(); ++it) {
+      auto &&entry = *it;
+      visitor(entry.first.first, entry.first.second);
+    }
+  }
+
+  /** Remove every pair by starting over with an empty data file. No iterator or page guard of this tree may be alive. */
+  void clear() {
+    delete bpm_;
+    std::remove((index_name_ + "_dt").c_str());
+    bpm_ = new BufferPoolManager{index_name_, pool_size_, replacer_k_, replacer_type_, PageSize};
+    bpm_->FetchPageWrite(header_page_id_).AsMut<BPlusTreeHeaderPage>()->root_page_id_ = INVALID_PAGE_ID;
+    insert_hint_.page_id_ = INVALID_PAGE_ID;
+    if (bloom_filter_ != nullptr) {
+      bloom_filter_->Reset(MIN_BLOOM_CAPACITY);
+    }
+  }
+
   // Index iterator
   auto Begin() -> INDEXITERATOR_TYPE {
     auto header_page = bpm_->FetchPageRead(header_page_id_).As<BPlusTreeHeaderPage>();
@@ -150,33 +450,31 @@ class BPlusTree {
   }
 
  private:
-  auto LowerBound(const LeafPage *page, const KeyType &key) const -> int {
-    int l = 0;
-    int r = page->GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (comparator_(page->KeyAt(mid), key) == -1) {
-        l = mid + 1;
-      } else {
-        r = mid;
-      }
-    }
-    return l;
-  }
+  /** Leaf of the last insert and the key range the internal pages above it route to it, see InsertAtHint(). */
+  struct InsertHint {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    KeyType lower_{};
+    KeyType upper_{};
+    bool has_lower_{false};
+    bool has_upper_{false};
+  };
 
-  auto LowerBound(const InternalPage *page, const KeyType &key) const -> int {
-    int l = 0;
-    int r = page->GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (comparator_(page->KeyAt(mid), key) == -1) {
-        l = mid + 1;
-      } else {
-        r = mid;
-      }
+  /** Feeds BuildPacked() from a sorted array of keys, the same way an IndexIterator does. */
+  class EntryRange {
+   public:
+    EntryRange(const KeyType *begin, const KeyType *end) : cur_(begin), end_(end) {}
+    auto IsEnd() const -> bool { return cur_ == end_; }
+    auto operator*() const -> pair<KeyType, ValueType> { return {*cur_, ValueType{}}; }
+    auto operator++() -> EntryRange & {
+      ++cur_;
+      return *this;
     }
-    return l;
-  }
+
+   private:
+    const KeyType *cur_;
+    const KeyType *end_;
+  };
+  auto LowerBound(const LeafPage *page, const KeyType &key) const -> int { return page->LowerBound(key, comparator_); }
 
   // binary search，找不到返回-1
   auto BinarySearch(const LeafPage *page, const KeyType &key) const -> int {
@@ -187,45 +485,14 @@ class BPlusTree {
     return l;
   }
 
-  auto UpperBound(const LeafPage *page, const KeyType &key) const -> int {
-    int l = 0;
-    int r = page->GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (comparator_(key, page->KeyAt(mid)) == -1) {
-        r = mid;
-      } else {
-        l = mid + 1;
-      }
-    }
-    return l;
-  }
+  auto UpperBound(const LeafPage *page, const KeyType &key) const -> int { return page->UpperBound(key, comparator_); }
   // upper bound. 返回第一个大于key的index
   auto UpperBound(const InternalPage *page, const KeyType &key) const -> int {
-    int l = 1;
-    int r = page->GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (comparator_(key, page->KeyAt(mid)) == -1) {
-        r = mid;
-      } else {
-        l = mid + 1;
-      }
-    }
-    return l;
+    return page->UpperBound(key, comparator_);
   }
 
   auto InsertKeyValue(LeafPage *page, const KeyType &key, const ValueType &value) const -> bool {
-    int l = 0;
-    int r = page->GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (comparator_(page->KeyAt(mid), key) == -1) {
-        l = mid + 1;
-      } else {
-        r = mid;
-      }
-    }
+    auto l = LowerBound(page, key);
     if (l == page->GetSize() || comparator_(key, page->KeyAt(l)) != 0) {
       page->InsertAt(l, key, value);
       return true;
@@ -239,10 +506,9 @@ class BPlusTree {
 
     n_page->Init(leaf_max_size_);
     auto size = page->GetSize();
-    for (int i = size >> 1; i < size; ++i) {
-      n_page->InsertAt(n_page->GetSize(), page->PairAt(i));
-    }
-    page->SetSize(size >> 1);
+    auto mid = page->SplitIndex();
+    n_page->AppendFrom(page, mid, size);
+    page->SetSize(mid);
     n_page->SetNextPageId(page->GetNextPageId());
     page->SetNextPageId(*n_page_id);
     if (ctx.IsRootPage(ctx.write_set_.back().PageId())) {  // 根是叶子，新根
@@ -276,9 +542,7 @@ class BPlusTree {
     auto *n_page = n_page_guard.AsMut<InternalPage>();
     n_page->Init(internal_max_size_);
     auto size = page->GetSize();
-    for (int i = size >> 1; i < size; ++i) {
-      n_page->InsertAt(n_page->GetSize(), page->PairAt(i));
-    }
+    n_page->AppendFrom(page, size >> 1, size);
     page->SetSize(size >> 1);
     if (ctx.IsRootPage(ctx.write_set_.back().PageId())) {  // 新根
       page_id_t n_root_page_id;
@@ -318,7 +582,7 @@ class BPlusTree {
       auto r_page_id = p_page->ValueAt(l + 1);
       auto r_page_guard = bpm_->FetchPageWrite(r_page_id);
       auto *r_page = r_page_guard.template AsMut<LeafPage>();
-      if (r_page->GetSize() > r_page->GetMinSize()) {
+      if (r_page->CanLend()) {
         page->InsertAt(page->GetSize(), r_page->PairAt(0));
         r_page->RemoveAt(0);
         p_page->SetKeyAt(l + 1, r_page->KeyAt(0));
@@ -333,7 +597,7 @@ class BPlusTree {
       auto l_page_id = p_page->ValueAt(l - 1);
       auto l_page_guard = bpm_->FetchPageWrite(l_page_id);
       auto *l_page = l_page_guard.template AsMut<LeafPage>();
-      if (l_page->GetSize() > l_page->GetMinSize()) {
+      if (l_page->CanLend()) {
         page->InsertAt(0, l_page->PairAt(l_page->GetSize() - 1));
         l_page->RemoveAt(l_page->GetSize() - 1);
         p_page->SetKeyAt(l, page->KeyAt(0));
@@ -361,12 +625,11 @@ class BPlusTree {
       auto r_page_guard = bpm_->FetchPageWrite(r_page_id);
       auto *r_page = r_page_guard.template AsMut<LeafPage>();
       //    std::cout << "Merging r_page: " << r_page->ToString() << " to page: " << page->ToString() << "\n";  // debug
-      for (int i = 0; i < r_page->GetSize(); ++i) {
-        page->InsertAt(page->GetSize(), r_page->PairAt(i));
-      }
+      page->AppendFrom(r_page, 0, r_page->GetSize());
       r_page->SetSize(0);
       page->SetNextPageId(r_page->GetNextPageId());
       p_page->RemoveAt(l + 1);
+      r_page_guard.Drop();  // a pinned page cannot be deleted
       bpm_->DeletePage(r_page_id);
       ctx.write_set_.pop_back();
       ctx.index_set_.pop_back();
@@ -377,15 +640,14 @@ class BPlusTree {
     auto l_page_guard = bpm_->FetchPageWrite(l_page_id);
     auto *l_page = l_page_guard.template AsMut<LeafPage>();
     //  std::cout << "Merging page: " << page->ToString() << " to l_page: " << l_page->ToString() << "\n";  // debug
-    for (int i = 0; i < page->GetSize(); ++i) {
-      l_page->InsertAt(l_page->GetSize(), page->PairAt(i));
-    }
+    l_page->AppendFrom(page, 0, page->GetSize());
     page->SetSize(0);
     l_page->SetNextPageId(page->GetNextPageId());
     p_page->RemoveAt(l);
-    bpm_->DeletePage(p_page->ValueAt(l));
+    auto page_id = ctx.write_set_.back().PageId();
     ctx.write_set_.pop_back();
     ctx.index_set_.pop_back();
+    bpm_->DeletePage(page_id);
     //  std::cout << "Successfully merged. After merging, l_page: " << l_page->ToString() << "\n";  // debug
   }
 
@@ -444,11 +706,10 @@ class BPlusTree {
       auto r_page_guard = bpm_->FetchPageWrite(r_page_id);
       auto *r_page = r_page_guard.template AsMut<InternalPage>();
       //    std::cout << "Merging r_page: " << r_page->ToString() << " to page: " << page->ToString() << "\n";  // debug
-      for (int i = 0; i < r_page->GetSize(); ++i) {
-        page->InsertAt(page->GetSize(), r_page->PairAt(i));
-      }
+      page->AppendFrom(r_page, 0, r_page->GetSize());
       r_page->SetSize(0);
       p_page->RemoveAt(l + 1);
+      r_page_guard.Drop();  // a pinned page cannot be deleted
       bpm_->DeletePage(r_page_id);
       ctx.write_set_.pop_back();
       ctx.index_set_.pop_back();
@@ -459,21 +720,48 @@ class BPlusTree {
     auto l_page_guard = bpm_->FetchPageWrite(l_page_id);
     auto *l_page = l_page_guard.template AsMut<InternalPage>();
     //  std::cout << "Merging page: " << page->ToString() << " to l_page: " << l_page->ToString() << "\n";  // debug
-    for (int i = 0; i < page->GetSize(); ++i) {
-      l_page->InsertAt(l_page->GetSize(), page->PairAt(i));
-    }
+    l_page->AppendFrom(page, 0, page->GetSize());
     page->SetSize(0);
     p_page->RemoveAt(l);
-    bpm_->DeletePage(p_page->ValueAt(l));
+    auto page_id = ctx.write_set_.back().PageId();
     ctx.write_set_.pop_back();
     ctx.index_set_.pop_back();
+    bpm_->DeletePage(page_id);
     //  std::cout << "Successfully merged. After merging, l_page: " << l_page->ToString() << "\n";  // debug
   }
 
+  /**
+   * Insert into the leaf of the previous insert without descending, if key still routes there and the leaf takes
+   * it without a split. Ascending keys, at the right edge of the tree or within a run such as the dates of one
+   * train, then cost one page fetch each until the leaf fills up.
+   * @param[out] inserted false if key was already present
+   * @return false if the hint does not apply and the full insert path has to run
+   */
+  auto InsertAtHint(const KeyType &key, const ValueType &value, bool *inserted) -> bool {
+    if (insert_hint_.page_id_ == INVALID_PAGE_ID ||
+        (insert_hint_.has_lower_ && comparator_(key, insert_hint_.lower_) < 0) ||
+        (insert_hint_.has_upper_ && comparator_(key, insert_hint_.upper_) >= 0)) {
+      return false;
+    }
+    // Back-to-back inserts into one leaf are correlated references. Counting each of them would make the leaves
+    // look hotter than the internal pages above them to LRU-K, so they are fetched like a scan.
+    auto guard = bpm_->FetchPageWrite(insert_hint_.page_id_, AccessType::Scan);
+    auto *leaf_page = guard.template AsMut<LeafPage>();
+    if (!leaf_page->HasSpareRoom()) {
+      return false;
+    }
+    *inserted = InsertKeyValue(leaf_page, key, value);
+    return true;
+  }
+
   /**
    * @return whether insert successfully and if false, whether it is because leaf node unsafe.
    */
   auto insert(const KeyType &key, const ValueType &value) -> pair<bool, bool> {
+    bool inserted;
+    if (InsertAtHint(key, value, &inserted)) {
+      return {inserted, false};
+    }
     Context ctx;
     ctx.header_write_guard_ = bpm_->FetchPageWrite(header_page_id_);
     ctx.root_page_id_ = ctx.header_write_guard_->AsMut<BPlusTreeHeaderPage>()->root_page_id_;
@@ -488,6 +776,7 @@ class BPlusTree {
       return {true, true};
     }
 
+    InsertHint hint;
     ctx.write_set_.push_back(bpm_->FetchPageWrite(ctx.root_page_id_));
     auto bpt_page = ctx.write_set_.back().AsMut<BPlusTreePage>();
     while (!bpt_page->IsLeafPage()) {
@@ -499,13 +788,24 @@ class BPlusTree {
       auto *internal_page = reinterpret_cast<InternalPage *>(bpt_page);
 
       auto l = UpperBound(internal_page, key) - 1;
+      if (l > 0) {
+        hint.lower_ = internal_page->KeyAt(l);
+        hint.has_lower_ = true;
+      }
+      if (l + 1 < internal_page->GetSize()) {
+        hint.upper_ = internal_page->KeyAt(l + 1);
+        hint.has_upper_ = true;
+      }
       ctx.write_set_.push_back(bpm_->FetchPageWrite(internal_page->ValueAt(l)));
       bpt_page = ctx.write_set_.back().AsMut<BPlusTreePage>();
     }
     auto *leaf_page = reinterpret_cast<LeafPage *>(bpt_page);
+    hint.page_id_ = ctx.write_set_.back().PageId();
 
     if (InsertKeyValue(leaf_page, key, value)) {
-      if (leaf_page->GetSize() == leaf_page->GetMaxSize()) {
+      insert_hint_ = hint;
+      if (leaf_page->IsFull()) {
+        insert_hint_.page_id_ = INVALID_PAGE_ID;
         page_id_t n_page_id;
         SplitLeafPage(leaf_page, &n_page_id, ctx);
         InternalPage *internal_page;
@@ -533,6 +833,7 @@ class BPlusTree {
    * @return whether insert successfully and if false, whether it is because leaf node unsafe.
    */
   auto remove(const KeyType &key) -> pair<bool, bool> {
+    insert_hint_.page_id_ = INVALID_PAGE_ID;  // merges and adoptions move the separators
     Context ctx;
     // 用栈模拟递归
     ctx.header_write_guard_ = bpm_->FetchPageWrite(header_page_id_);
@@ -559,12 +860,13 @@ class BPlusTree {
     auto leaf_page = reinterpret_cast<LeafPage *>(bpt_page);
     RemoveKeyValue(leaf_page, key);
 
-    if (leaf_page->GetSize() >= leaf_page->GetMinSize()) {
+    if (!leaf_page->IsUnderfull()) {
       return {true, false};
     }
     if (ctx.IsRootPage(ctx.write_set_.back().PageId())) {  // 根就是叶子
       if (leaf_page->GetSize() == 0) {
         ctx.header_write_guard_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = INVALID_PAGE_ID;
+        ctx.write_set_.pop_back();
         bpm_->DeletePage(ctx.root_page_id_);
       }
       return {true, false};
@@ -586,48 +888,202 @@ class BPlusTree {
     // 2. ctx.write_set_中仅剩安全节点的写锁，什么都不用做
     if (page->GetSize() == 1) {
       ctx.header_write_guard_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = page->ValueAt(0);
+      ctx.write_set_.pop_back();
       bpm_->DeletePage(ctx.root_page_id_);
     }
     return {true, false};
   }
 
-  void find(const KeyType &key, vector<KeySecond> &result, ReadPageGuard &guard) {
-    auto *page = guard.template As<BPlusTreePage>();
-    if (page->IsLeafPage()) {
-      auto leaf_page = reinterpret_cast<const LeafPage *>(page);
-      int l = leaf_page->LowerBoundByFirst(key, comparator_);
-      int r = leaf_page->UpperBoundByFirst(key, comparator_);
-      for (int i = l; i < r; ++i) {
-        result.push_back(leaf_page->KeyAt(i).second);
-      }
-      guard.Drop();
+  // read a page as of snapshot, or as it is now if snapshot is nullptr
+  auto FetchRead(page_id_t page_id, const Snapshot *snapshot) -> ReadPageGuard {
+    return snapshot == nullptr ? bpm_->FetchPageRead(page_id) : bpm_->FetchPageSnapshot(page_id, snapshot->GetEpoch());
+  }
+
+  template <class Visitor>
+  void ForEach(const KeyFirst &key, Visitor &visitor, const Snapshot *snapshot) {
+    auto header_page_guard = FetchRead(header_page_id_, snapshot);
+    auto header_page = header_page_guard.template As<BPlusTreeHeaderPage>();
+    if (header_page->root_page_id_ == INVALID_PAGE_ID) {
+      header_page_guard.Drop();
       return;
     }
-    auto internal_page = reinterpret_cast<const InternalPage *>(page);
-    int l = internal_page->LowerBoundByFirst(key, comparator_) - 1;
-    int r = internal_page->UpperBoundByFirst(key, comparator_) - 1;
+    auto guard = FetchRead(header_page->root_page_id_, snapshot);
+    header_page_guard.Drop();
+    KeyType search_key{key, {}};
+    auto bpt_page = guard.template As<BPlusTreePage>();
+    while (!bpt_page->IsLeafPage()) {
+      auto internal_page = reinterpret_cast<const InternalPage *>(bpt_page);
+      int l = internal_page->LowerBoundByFirst(search_key, comparator_) - 1;
+      auto child_guard = FetchRead(internal_page->ValueAt(l), snapshot);
+      bpt_page = child_guard.template As<BPlusTreePage>();
+      if (bpt_page->IsLeafPage()) {
+        // the run of key spans the children l..r, start reading the ones after l while l is scanned
+        int r = std::min(internal_page->UpperBoundByFirst(search_key, comparator_) - 1, l + READ_AHEAD_PAGES);
+        for (int i = l + 1; i <= r; ++i) {
+          bpm_->PrefetchPage(internal_page->ValueAt(i));
+        }
+      }
+      guard = std::move(child_guard);
+    }
+    ScanLeafChain(search_key, reinterpret_cast<const LeafPage *>(bpt_page), guard, visitor, snapshot);
+  }
 
-    //    page_id_t son_page_id[INTERNAL_PAGE_SIZE+2];
-    //    for (int i = l; i <= r; ++i) {
-    //      son_page_id[i - l] = internal_page->ValueAt(i);
-    //    }
-    //    guard.Drop();
-    for (int i = l; i <= r; ++i) {
-      auto n_guard = bpm_->FetchPageRead(internal_page->ValueAt(i));
-      find(key, result, n_guard);
+  /**
+   * Visit the entries sharing the first component of key, from its lower bound in leaf_page on. A run of equal
+   * keys may continue into the following leaves, which are read through next_page_id_ into guard one at a time.
+   * @return false if the visitor asked to stop
+   */
+  template <class Visitor>
+  auto ScanLeafChain(const KeyType &key, const LeafPage *leaf_page, ReadPageGuard &guard, Visitor &visitor,
+                     const Snapshot *snapshot = nullptr) -> bool {
+    int i = leaf_page->LowerBoundByFirst(key, comparator_);
+    while (true) {
+      int end = leaf_page->UpperBoundByFirst(key, comparator_);
+      for (; i < end; ++i) {
+        if (!visitor(leaf_page->SecondAt(i))) {
+          return false;
+        }
+      }
+      if (end < leaf_page->GetSize() || leaf_page->GetNextPageId() == INVALID_PAGE_ID) {
+        return true;
+      }
+      guard = FetchRead(leaf_page->GetNextPageId(), snapshot);
+      leaf_page = guard.template As<LeafPage>();
+      i = 0;
     }
   }
 
+  /**
+   * Refill the Bloom filter from a scan of all leaves, sized at twice the number of distinct first keys.
+   * Also called when the filter fills up, which drops the keys removed since the last rebuild.
+   */
+  void RebuildBloomFilter() {
+    vector<uint64_t> hashes;
+    KeyFirst last_key{};
+    for (auto it = Begin(); !it.IsEnd(); ++it) {
+      KeyFirst key = (*it).first.first;
+      if (hashes.empty() || comparator_(key, last_key) != 0) {
+        hashes.push_back(HashKey(key));
+        last_key = key;
+      }
+    }
+    bloom_filter_->Reset(std::max(MIN_BLOOM_CAPACITY, hashes.size() * 2));
+    for (size_t i = 0; i < hashes.size(); ++i) {
+      bloom_filter_->Insert(hashes[i]);
+    }
+  }
+
+  /**
+   * Build a tree in new pages of bpm, bottom up: leaves are streamed from source and filled to fill_factor, then
+   * every internal level is split evenly over as few pages as the fill factor allows. Page sizes never drop below
+   * the minimum a merge would restore.
+   * @param source an IndexIterator or EntryRange over sorted entries, left at its end
+   * @return the root page id in bpm, INVALID_PAGE_ID if source is empty
+   */
+  template <class Source>
+  auto BuildPacked(BufferPoolManager *bpm, double fill_factor, Source &source) -> page_id_t {
+    // leaves split when they reach max size, internal pages when they exceed it
+    int leaf_min = leaf_max_size_ >> 1;
+    int leaf_fill = std::clamp(static_cast<int>(fill_factor * (leaf_max_size_ - 1)), leaf_min, leaf_max_size_ - 1);
+    vector<KeyType> keys;  // first key below each page of the level just built
+    vector<page_id_t> children;
+    BasicPageGuard prev_guard;
+    BasicPageGuard cur_guard;
+    LeafPage *prev = nullptr;
+    LeafPage *cur = nullptr;
+    for (; !source.IsEnd(); ++source) {
+      auto entry = *source;
+      if (cur == nullptr || cur->GetSize() == leaf_fill || !cur->HasSpareRoom()) {
+        page_id_t page_id;
+        auto guard = bpm->NewPageGuarded(&page_id);
+        auto *page = guard.template AsMut<LeafPage>();
+        page->Init(leaf_max_size_);
+        if (cur != nullptr) {
+          cur->SetNextPageId(page_id);
+        }
+        prev_guard = std::move(cur_guard);
+        cur_guard = std::move(guard);
+        prev = cur;
+        cur = page;
+        keys.push_back(entry.first);
+        children.push_back(page_id);
+      }
+      cur->InsertAt(cur->GetSize(), entry);
+    }
+    if (cur == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    if (prev != nullptr && cur->IsUnderfull()) {
+      // the last leaf is short: fold it into the one before, or take half of that one
+      if (prev->CanMerge(cur)) {
+        prev->AppendFrom(cur, 0, cur->GetSize());
+        prev->SetNextPageId(INVALID_PAGE_ID);
+        cur_guard.Drop();
+        bpm->DeletePage(children.back());
+        keys.pop_back();
+        children.pop_back();
+      } else {
+        while (cur->GetSize() < prev->GetSize() && cur->HasSpareRoom()) {
+          cur->InsertAt(0, prev->PairAt(prev->GetSize() - 1));
+          prev->SetSize(prev->GetSize() - 1);
+        }
+        keys[keys.size() - 1] = cur->KeyAt(0);
+      }
+    }
+    prev_guard.Drop();
+    cur_guard.Drop();
+
+    int internal_min = (internal_max_size_ + 1) >> 1;
+    auto internal_fill = static_cast<size_t>(
+        std::clamp(static_cast<int>(fill_factor * internal_max_size_), internal_min, internal_max_size_));
+    while (children.size() > 1) {
+      size_t count = children.size();
+      size_t nodes = (count + internal_fill - 1) / internal_fill;
+      while (nodes > 1 && count / nodes < static_cast<size_t>(internal_min)) {
+        --nodes;
+      }
+      vector<KeyType> parent_keys;
+      vector<page_id_t> parents;
+      size_t pos = 0;
+      for (size_t n = 0; n < nodes; ++n) {
+        size_t size = count / nodes + (n < count % nodes ? 1 : 0);
+        page_id_t page_id;
+        auto guard = bpm->NewPageGuarded(&page_id);
+        auto *page = guard.template AsMut<InternalPage>();
+        page->Init(internal_max_size_);
+        parent_keys.push_back(keys[pos]);
+        parents.push_back(page_id);
+        // slot 0 keeps the first key of the page too, merges move it down as the separator
+        for (size_t i = 0; i < size; ++i, ++pos) {
+          page->InsertAt(static_cast<int>(i), keys[pos], children[pos]);
+        }
+      }
+      keys = parent_keys;
+      children = parents;
+    }
+    return children[0];
+  }
+
+  static constexpr double PACK_FILL_FACTOR = 0.9;  // leaves keep room for a few inserts before splitting
+  static constexpr size_t MIN_BLOOM_CAPACITY = 1024;
+  static constexpr int MAX_HEIGHT = 32;
+
   // member variable
   std::string index_name_;
   BufferPoolManager *bpm_;
+  size_t pool_size_;
+  size_t replacer_k_;
+  ReplacerType replacer_type_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t header_page_id_;
+  BloomFilter *bloom_filter_{nullptr};
+  MyFile *bloom_file_{nullptr};
+  InsertHint insert_hint_;
 };
 
-template <class KeyType, class ValueType>
-using BPT = BPlusTree<KeyType, ValueType, char, Comparator<KeyType, ValueType, char>>;
+template <class KeyType, class ValueType, int PageSize = BUSTUB_PAGE_SIZE, LeafFormat Format = LeafFormat::Plain>
+using BPT = BPlusTree<KeyType, ValueType, char, Comparator<KeyType, ValueType, char>, PageSize, Format>;
 
 }  // namespace CrazyDave
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/hash_util.h"
+#include "storage/disk/file_wrapper.h"
+
+namespace CrazyDave {
+
+/**
+ * BloomFilter answers "definitely absent" for keys that were never inserted, so that point lookups on an
+ * index can skip the tree descent for most unknown keys.
+ *
+ * It is a blocked filter: every key maps to one 64-byte block and sets NUM_PROBES bits inside it, so a
+ * lookup touches a single cache line. Keys cannot be removed; the owner rebuilds the filter from a scan
+ * when the number of insertions outgrows the capacity it was sized for.
+ *
+ * File format (written by Save, read by Load):
+ * --------------------------------------------------------------------------
+ * | Magic (4) | IsDirty (4) | Capacity (8) | InsertCount (8) | Words (8 * n) |
+ * --------------------------------------------------------------------------
+ */
+class BloomFilter {
+ public:
+  BloomFilter() = default;
+  BloomFilter(const BloomFilter &other) = delete;
+  ~BloomFilter();
+
+  /**
+   * @brief Clear the filter and size it for `capacity` keys.
+   */
+  void Reset(size_t capacity);
+
+  void Insert(uint64_t hash);
+
+  /** @return false if the key with this hash was definitely never inserted */
+  auto MayContain(uint64_t hash) const -> bool;
+
+  /** @return number of keys the filter was sized for */
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+  /** @return number of insertions since the last Reset */
+  auto GetInsertCount() const -> size_t { return insert_count_; }
+
+  /**
+   * @brief Write the filter to the start of the file, with the dirty flag cleared.
+   */
+  void Save(MyFile &file) const;
+
+  /**
+   * @brief Read a filter written by Save.
+   * @return false if the file holds no filter or the filter was not saved on a clean shutdown
+   */
+  auto Load(MyFile &file) -> bool;
+
+  /**
+   * @brief Set the dirty flag in the file, so that a crash before the next Save forces a rebuild.
+   */
+  static void MarkDirty(MyFile &file);
+
+ private:
+  static constexpr uint32_t MAGIC = 0x424c4d31;  // "BLM1"
+  static constexpr size_t BITS_PER_KEY = 10;
+  static constexpr size_t BLOCK_WORDS = 8;  // 64-byte blocks
+  static constexpr int NUM_PROBES = 6;
+
+  /** The block is chosen by the high 32 bits, the probes inside it use the low bits. */
+  auto BlockIndex(uint64_t hash) const -> size_t { return ((hash >> 32) * num_blocks_) >> 32; }
+
+  uint64_t *words_{nullptr};
+  size_t num_blocks_{0};
+  size_t capacity_{0};
+  size_t insert_count_{0};
+};
+
+}  // namespace CrazyDave
@@ -0,0 +1,370 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/hash_util.h"
+#include "common/utils.h"
+#include "data_structures/vector.h"
+#include "storage/page/extendible_htable_bucket_page.h"
+#include "storage/page/extendible_htable_directory_page.h"
+#include "storage/page/extendible_htable_header_page.h"
+#include "storage/page/page_guard.h"
+
+namespace CrazyDave {
+
+/**
+ * Shape of an extendible hash table, gathered by visiting every page of it.
+ */
+struct ExtendibleHashTableStats {
+  uint32_t max_global_depth_{0};
+  size_t directory_pages_{0};
+  size_t bucket_pages_{0};
+  size_t entries_{0};
+  // Sum of the max sizes of all buckets, entries_ / bucket_slots_ is the bucket fill factor.
+  size_t bucket_slots_{0};
+};
+
+/**
+ * Disk-based extendible hash table for tables that are only ever looked up by exact key. It has the same
+ * insert / remove / find surface as BPlusTree, but a lookup reads the header, one directory and one bucket
+ * page, no matter how large the table grows.
+ *
+ * The first key component is hashed, so all entries sharing it land in the same bucket. Like in the B+ tree,
+ * the whole pair is the unique key and find() returns the second components in ascending order.
+ *
+ * A bucket can only split while its local depth is below the directory max depth, the default depths allow
+ * 2^(2 + 11) buckets. Inserting into a full bucket beyond that fails and returns false.
+ */
+template <typename KeyFirst, typename KeySecond, typename KeyComparator>
+class ExtendibleHashTable {
+  using KeyType = pair<KeyFirst, KeySecond>;
+  using HeaderPage = ExtendibleHTableHeaderPage;
+  using DirectoryPage = ExtendibleHTableDirectoryPage;
+  using BucketPage = ExtendibleHTableBucketPage<KeyType, KeyComparator>;
+
+ public:
+  static constexpr uint32_t DEFAULT_HEADER_MAX_DEPTH = 2;
+
+  explicit ExtendibleHashTable(std::string name, page_id_t header_page_id, size_t pool_size, size_t replacer_k,
+                               ReplacerType replacer_type = ReplacerType::LRUK,
+                               uint32_t header_max_depth = DEFAULT_HEADER_MAX_DEPTH,
+                               uint32_t directory_max_depth = HTABLE_DIRECTORY_MAX_DEPTH,
+                               uint32_t bucket_max_size = HTABLE_BUCKET_ARRAY_SIZE)
+      : index_name_(std::move(name)),
+        pool_size_(pool_size),
+        replacer_k_(replacer_k),
+        replacer_type_(replacer_type),
+        header_page_id_(header_page_id),
+        header_max_depth_(header_max_depth),
+        directory_max_depth_(directory_max_depth),
+        bucket_max_size_(bucket_max_size) {
+    bpm_ = new BufferPoolManager{index_name_, pool_size, replacer_k, replacer_type};
+    if (bpm_->IsNew()) {
+      WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
+      guard.AsMut<HeaderPage>()->Init(header_max_depth);
+    }
+  }
+  ~ExtendibleHashTable() { delete bpm_; }
+
+  /**
+   * @return false if the pair is already present, or its bucket is full and cannot split any more
+   */
+  auto insert(const KeyFirst &key, const KeySecond &value) -> bool {
+    KeyType entry{key, value};
+    auto hash = HashKey(key);
+    WritePageGuard header_guard = bpm_->FetchPageWrite(header_page_id_);
+    auto *header_page = header_guard.AsMut<HeaderPage>();
+    auto directory_idx = header_page->HashToDirectoryIndex(hash);
+    auto directory_page_id = header_page->GetDirectoryPageId(directory_idx);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      directory_page_id = NewDirectory();
+      header_page->SetDirectoryPageId(directory_idx, directory_page_id);
+    }
+    header_guard.Drop();
+
+    WritePageGuard directory_guard = bpm_->FetchPageWrite(directory_page_id);
+    auto *directory_page = directory_guard.AsMut<DirectoryPage>();
+    while (true) {
+      auto bucket_idx = directory_page->HashToBucketIndex(hash);
+      WritePageGuard bucket_guard = bpm_->FetchPageWrite(directory_page->GetBucketPageId(bucket_idx));
+      auto *bucket_page = bucket_guard.AsMut<BucketPage>();
+      auto l = bucket_page->LowerBound(entry, comparator_);
+      if (l < bucket_page->GetSize() && comparator_(bucket_page->KeyAt(l), entry) == 0) {
+        return false;
+      }
+      if (!bucket_page->IsFull()) {
+        bucket_page->InsertAt(l, entry);
+        return true;
+      }
+      if (!SplitBucket(directory_page, bucket_idx, bucket_page)) {
+        return false;
+      }
+    }
+  }
+
+  /**
+   * @return false if the pair is not present
+   */
+  auto remove(const KeyFirst &key, const KeySecond &value) -> bool {
+    KeyType entry{key, value};
+    auto hash = HashKey(key);
+    auto directory_page_id = GetDirectoryPageId(hash);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    WritePageGuard directory_guard = bpm_->FetchPageWrite(directory_page_id);
+    auto *directory_page = directory_guard.AsMut<DirectoryPage>();
+    auto bucket_idx = directory_page->HashToBucketIndex(hash);
+    {
+      WritePageGuard bucket_guard = bpm_->FetchPageWrite(directory_page->GetBucketPageId(bucket_idx));
+      auto *bucket_page = bucket_guard.AsMut<BucketPage>();
+      auto l = bucket_page->LowerBound(entry, comparator_);
+      if (l == bucket_page->GetSize() || comparator_(bucket_page->KeyAt(l), entry) != 0) {
+        return false;
+      }
+      bucket_page->RemoveAt(l);
+      if (!bucket_page->IsEmpty()) {
+        return true;
+      }
+    }
+    MergeBuckets(directory_page, bucket_idx);
+    while (directory_page->CanShrink()) {
+      directory_page->DecrGlobalDepth();
+    }
+    return true;
+  }
+
+  /**
+   * Call visitor(value) with a const reference into the pinned bucket for every value stored under key, in
+   * ascending order. The visitor returns false to stop early.
+   */
+  template <class Visitor>
+  void for_each(const KeyFirst &key, Visitor &&visitor) {
+    auto hash = HashKey(key);
+    auto directory_page_id = GetDirectoryPageId(hash);
+    if (directory_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    ReadPageGuard directory_guard = bpm_->FetchPageRead(directory_page_id);
+    auto *directory_page = directory_guard.As<DirectoryPage>();
+    auto bucket_page_id = directory_page->GetBucketPageId(directory_page->HashToBucketIndex(hash));
+    directory_guard.Drop();
+
+    ReadPageGuard bucket_guard = bpm_->FetchPageRead(bucket_page_id);
+    auto *bucket_page = bucket_guard.As<BucketPage>();
+    for (auto i = bucket_page->LowerBoundByFirst(key, comparator_);
+         i < bucket_page->GetSize() && comparator_(bucket_page->KeyAt(i).first, key) == 0; ++i) {
+      if (!visitor(bucket_page->KeyAt(i).second)) {
+        return;
+      }
+    }
+  }
+
+  // Copy the smallest value stored under key into out. Return false if there is none
+  auto find_first(const KeyFirst &key, KeySecond &out) -> bool {
+    bool found = false;
+    for_each(key, [&](const KeySecond &value) {
+      out = value;
+      found = true;
+      return false;
+    });
+    return found;
+  }
+
+  // Append the second components of all pairs whose first component is key
+  void find(const KeyFirst &key, vector<KeySecond> &result) {
+    for_each(key, [&](const KeySecond &value) {
+      result.push_back(value);
+      return true;
+    });
+  }
+
+  // Call visitor(key, value) for every pair, bucket by bucket in the order of the hashes
+  template <class Visitor>
+  void for_all(Visitor &&visitor) {
+    vector<page_id_t> directory_page_ids;
+    CollectDirectories(directory_page_ids);
+    for (size_t i = 0; i < directory_page_ids.size(); ++i) {
+      ReadPageGuard directory_guard = bpm_->FetchPageRead(directory_page_ids[i]);
+      auto *directory_page = directory_guard.As<DirectoryPage>();
+      for (uint32_t j = 0; j < directory_page->Size(); ++j) {
+        if (j >= (1U << directory_page->GetLocalDepth(j))) {
+          continue;
+        }
+        ReadPageGuard bucket_guard = bpm_->FetchPageRead(directory_page->GetBucketPageId(j), AccessType::Scan);
+        auto *bucket_page = bucket_guard.As<BucketPage>();
+        for (uint32_t k = 0; k < bucket_page->GetSize(); ++k) {
+          visitor(bucket_page->KeyAt(k).first, bucket_page->KeyAt(k).second);
+        }
+      }
+    }
+  }
+
+  // Remove every pair by starting over with an empty data file. No page guard of this table may be alive
+  void clear() {
+    delete bpm_;
+    std::remove((index_name_ + "_dt").c_str());
+    bpm_ = new BufferPoolManager{index_name_, pool_size_, replacer_k_, replacer_type_};
+    WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
+    guard.AsMut<HeaderPage>()->Init(header_max_depth_);
+  }
+
+  // Return the buffer pool backing this table, e.g. to read its activity counters
+  auto GetBufferPoolManager() -> BufferPoolManager * { return bpm_; }
+
+  auto GetName() const -> const std::string & { return index_name_; }
+
+  // Visit every directory and bucket once. Touches every page, so keep it off hot paths.
+  auto GetTableStats() -> ExtendibleHashTableStats {
+    ExtendibleHashTableStats stats;
+    vector<page_id_t> directory_page_ids;
+    CollectDirectories(directory_page_ids);
+    for (size_t i = 0; i < directory_page_ids.size(); ++i) {
+      ReadPageGuard directory_guard = bpm_->FetchPageRead(directory_page_ids[i]);
+      auto *directory_page = directory_guard.As<DirectoryPage>();
+      ++stats.directory_pages_;
+      stats.max_global_depth_ = std::max(stats.max_global_depth_, directory_page->GetGlobalDepth());
+      for (uint32_t j = 0; j < directory_page->Size(); ++j) {
+        // a bucket of local depth d is counted at the lowest of the slots sharing it
+        if (j >= (1U << directory_page->GetLocalDepth(j))) {
+          continue;
+        }
+        ReadPageGuard bucket_guard = bpm_->FetchPageRead(directory_page->GetBucketPageId(j), AccessType::Scan);
+        auto *bucket_page = bucket_guard.As<BucketPage>();
+        ++stats.bucket_pages_;
+        stats.entries_ += bucket_page->GetSize();
+        stats.bucket_slots_ += bucket_page->GetMaxSize();
+      }
+    }
+    return stats;
+  }
+
+ private:
+  void CollectDirectories(vector<page_id_t> &directory_page_ids) {
+    ReadPageGuard header_guard = bpm_->FetchPageRead(header_page_id_);
+    auto *header_page = header_guard.As<HeaderPage>();
+    for (uint32_t i = 0; i < header_page->MaxSize(); ++i) {
+      if (header_page->GetDirectoryPageId(i) != INVALID_PAGE_ID) {
+        directory_page_ids.push_back(header_page->GetDirectoryPageId(i));
+      }
+    }
+  }
+
+  auto GetDirectoryPageId(uint64_t hash) -> page_id_t {
+    ReadPageGuard header_guard = bpm_->FetchPageRead(header_page_id_);
+    auto *header_page = header_guard.As<HeaderPage>();
+    return header_page->GetDirectoryPageId(header_page->HashToDirectoryIndex(hash));
+  }
+
+  // Create a directory of global depth 0 with a single empty bucket
+  auto NewDirectory() -> page_id_t {
+    page_id_t directory_page_id;
+    page_id_t bucket_page_id;
+    BasicPageGuard directory_guard = bpm_->NewPageGuarded(&directory_page_id);
+    BasicPageGuard bucket_guard = bpm_->NewPageGuarded(&bucket_page_id);
+    auto *directory_page = directory_guard.AsMut<DirectoryPage>();
+    directory_page->Init(directory_max_depth_);
+    directory_page->SetBucketPageId(0, bucket_page_id);
+    bucket_guard.AsMut<BucketPage>()->Init(bucket_max_size_);
+    return directory_page_id;
+  }
+
+  /**
+   * Split the bucket at bucket_idx by the next hash bit, doubling the directory first if needed.
+   * @return false if the directory is already at its max depth
+   */
+  auto SplitBucket(DirectoryPage *directory_page, uint32_t bucket_idx, BucketPage *bucket_page) -> bool {
+    auto local_depth = directory_page->GetLocalDepth(bucket_idx);
+    if (local_depth == directory_page->GetGlobalDepth()) {
+      if (directory_page->GetGlobalDepth() == directory_page->GetMaxDepth()) {
+        return false;
+      }
+      directory_page->IncrGlobalDepth();
+    }
+    page_id_t n_page_id;
+    BasicPageGuard n_page_guard = bpm_->NewPageGuarded(&n_page_id);
+    auto *n_page = n_page_guard.AsMut<BucketPage>();
+    n_page->Init(bucket_max_size_);
+
+    uint32_t step = 1U << local_depth;
+    for (uint32_t i = bucket_idx & (step - 1); i < directory_page->Size(); i += step) {
+      directory_page->SetLocalDepth(i, local_depth + 1);
+      if ((i & step) != 0) {
+        directory_page->SetBucketPageId(i, n_page_id);
+      }
+    }
+    // both halves keep the sorted order of the original bucket
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < bucket_page->GetSize(); ++i) {
+      auto &entry = bucket_page->KeyAt(i);
+      if ((HashKey(entry.first) & step) != 0) {
+        n_page->PushBack(entry);
+      } else {
+        if (size != i) {
+          bucket_page->SetKeyAt(size, entry);
+        }
+        ++size;
+      }
+    }
+    bucket_page->SetSize(size);
+    return true;
+  }
+
+  auto IsBucketEmpty(page_id_t bucket_page_id) -> bool {
+    ReadPageGuard guard = bpm_->FetchPageRead(bucket_page_id);
+    return guard.As<BucketPage>()->IsEmpty();
+  }
+
+  // Fold the bucket at bucket_idx into its split image as long as one of the two is empty
+  void MergeBuckets(DirectoryPage *directory_page, uint32_t bucket_idx) {
+    while (true) {
+      auto local_depth = directory_page->GetLocalDepth(bucket_idx);
+      if (local_depth == 0) {
+        return;
+      }
+      auto image_idx = directory_page->GetSplitImageIndex(bucket_idx);
+      if (directory_page->GetLocalDepth(image_idx) != local_depth) {
+        return;
+      }
+      auto bucket_page_id = directory_page->GetBucketPageId(bucket_idx);
+      auto image_page_id = directory_page->GetBucketPageId(image_idx);
+      page_id_t victim_page_id;
+      page_id_t survivor_page_id;
+      if (IsBucketEmpty(bucket_page_id)) {
+        victim_page_id = bucket_page_id;
+        survivor_page_id = image_page_id;
+      } else if (IsBucketEmpty(image_page_id)) {
+        victim_page_id = image_page_id;
+        survivor_page_id = bucket_page_id;
+      } else {
+        return;
+      }
+      uint32_t step = 1U << (local_depth - 1);
+      for (uint32_t i = bucket_idx & (step - 1); i < directory_page->Size(); i += step) {
+        directory_page->SetLocalDepth(i, local_depth - 1);
+        directory_page->SetBucketPageId(i, survivor_page_id);
+      }
+      bpm_->DeletePage(victim_page_id);
+    }
+  }
+
+  // member variable
+  std::string index_name_;
+  BufferPoolManager *bpm_;
+  size_t pool_size_;
+  size_t replacer_k_;
+  ReplacerType replacer_type_;
+  KeyComparator comparator_;
+  page_id_t header_page_id_;
+  uint32_t header_max_depth_;
+  uint32_t directory_max_depth_;
+  uint32_t bucket_max_size_;
+};
+
+template <class KeyType, class ValueType>
+using EHT = ExtendibleHashTable<KeyType, ValueType, Comparator<KeyType, ValueType, char>>;
+
+}  // namespace CrazyDave
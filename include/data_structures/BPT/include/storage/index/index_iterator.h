@@ -7,9 +7,11 @@
 
 namespace CrazyDave {
 
-#define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
+#define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator, PageSize, LeafPage>
 
-template <typename KeyType, typename ValueType, typename KeyComparator>
+// LeafPage is the leaf page type of the tree, see LeafFormat
+template <typename KeyType, typename ValueType, typename KeyComparator, int PageSize = BUSTUB_PAGE_SIZE,
+          typename LeafPage = B_PLUS_TREE_LEAF_PAGE_TYPE>
 class IndexIterator {
  public:
   // you may define your own constructor based on your member variables
@@ -18,15 +20,17 @@ class IndexIterator {
     if (page_id == INVALID_PAGE_ID) {
       is_end_ = true;
     } else {
-      guard_ = bpm_->FetchPageRead(page_id);
+      guard_ = bpm_->FetchPageRead(page_id, AccessType::Scan);
+      ReadAhead();
     }
   }
   ~IndexIterator() = default;  // NOLINT
 
   auto IsEnd() -> bool{ return is_end_; }
 
-  auto operator*() -> const MappingType &{
-    auto *page = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+  // a reference into the pinned leaf, or a copy for leaf formats that do not store MappingType
+  auto operator*() -> decltype(auto) {
+    auto *page = guard_.As<LeafPage>();
     return page->PairAt(pos_);
   }
 
@@ -34,7 +38,7 @@ class IndexIterator {
     if (is_end_) {
       return *this;
     }
-    auto *page = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+    auto *page = guard_.As<LeafPage>();
     ++pos_;
     if (pos_ == page->GetSize()) {
       auto next_page_id = page->GetNextPageId();
@@ -44,7 +48,8 @@ class IndexIterator {
       if (next_page_id == INVALID_PAGE_ID) {
         is_end_ = true;
       } else {
-        guard_ = bpm_->FetchPageRead(next_page_id);
+        guard_ = bpm_->FetchPageRead(next_page_id, AccessType::Scan);
+        ReadAhead();
       }
     }
     return *this;
@@ -63,6 +68,12 @@ class IndexIterator {
   auto operator!=(const IndexIterator &itr) const -> bool { return !(this->operator==(itr)); }
 
  private:
+  // start reading the next leaf while this one is iterated. Leaves are read as a scan, so walking the whole tree
+  // recycles a few frames of the pool instead of evicting the pages point lookups keep using.
+  void ReadAhead() {
+    bpm_->PrefetchPage(guard_.As<LeafPage>()->GetNextPageId(), AccessType::Scan);
+  }
+
   // add your own private member variables here
   BufferPoolManager *bpm_;
   ReadPageGuard guard_;
@@ -1,12 +1,14 @@
 #pragma once
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/key_prefix.h"
 
 namespace CrazyDave {
 
-#define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 12
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)) - 1)
+#define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator, PageSize>
+#define INTERNAL_PAGE_HEADER_SIZE 16
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -16,13 +18,18 @@ namespace CrazyDave {
  * should ignore the first key.
  *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  -----------------------------------------------------------------------------------------------------------
+ * | HEADER | PREFIX(1) | ... | PREFIX(n) | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ *  -----------------------------------------------------------------------------------------------------------
+ * PREFIX(i) is the leading integer of KEY(i), see key_prefix.h. The header is padded to 16 bytes to align them.
  */
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, int PageSize = BUSTUB_PAGE_SIZE>
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
+  /** Number of entries a page of PageSize bytes holds */
+  static constexpr int INTERNAL_PAGE_SIZE =
+      (PageSize - INTERNAL_PAGE_HEADER_SIZE) / static_cast<int>(sizeof(MappingType) + sizeof(int64_t)) - 1;
+
   // Deleted to disallow initialization
   BPlusTreeInternalPage() = delete;
 
@@ -50,7 +57,10 @@ class BPlusTreeInternalPage : public BPlusTreePage {
    * @param index The index of the key to set. Index must be non-zero.
    * @param key The new value for key
    */
-  void SetKeyAt(int index, const KeyType &key) { array_[index].first = key; }
+  void SetKeyAt(int index, const KeyType &key) {
+    array_[index].first = key;
+    prefix_[index] = KeyPrefix<KeyType>::Get(key);
+  }
 
   /**
    *
@@ -73,60 +83,82 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto ValueAt(int index) const -> ValueType { return array_[index].second; }
 
   void InsertAt(int index, const KeyType &key, const ValueType &value) {
-    for (int i = GetSize(); i > index; --i) {
-      array_[i] = array_[i - 1];
-    }
+    MoveEntries(index + 1, index, GetSize() - index);
     array_[index].first = key;
     array_[index].second = value;
+    prefix_[index] = KeyPrefix<KeyType>::Get(key);
     IncreaseSize(1);
   }
 
   void RemoveAt(int index) {
-    for (int i = index; i < GetSize() - 1; ++i) {
-      array_[i] = array_[i + 1];
-    }
+    MoveEntries(index, index + 1, GetSize() - index - 1);
     IncreaseSize(-1);
   }
 
   auto PairAt(int index) const -> const MappingType & { return array_[index]; }
 
   void InsertAt(int index, const MappingType &pair) {
-    for (int i = GetSize(); i > index; --i) {
-      array_[i] = array_[i - 1];
-    }
+    MoveEntries(index + 1, index, GetSize() - index);
     array_[index] = pair;
+    prefix_[index] = KeyPrefix<KeyType>::Get(pair.first);
     IncreaseSize(1);
   }
 
-  auto LowerBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int {
-    int l = 1;
-    int r = GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (cmp(array_[mid].first.first, key.first) == -1) {
-        l = mid + 1;
-      } else {
-        r = mid;
+  /** Append the entries [begin, end) of src to this page. */
+  void AppendFrom(const BPlusTreeInternalPage *src, int begin, int end) {
+    int n = end - begin;
+    if constexpr (TRIVIAL_ENTRIES) {
+      std::memcpy(array_ + GetSize(), src->array_ + begin, n * sizeof(MappingType));
+    } else {
+      for (int i = 0; i < n; ++i) {
+        array_[GetSize() + i] = src->array_[begin + i];
       }
     }
-    return l;
+    std::memcpy(prefix_ + GetSize(), src->prefix_ + begin, n * sizeof(int64_t));
+    IncreaseSize(n);
+  }
+
+  /** @return index of the first key greater than key, the first key is ignored */
+  auto UpperBound(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int r = PrefixUpperBound(prefix_, 1, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopUpperBound(1, r, [&](int i) { return cmp(key, array_[i].first) < 0; });
   }
 
+  /** @return index of the first key whose first component is not less than key's, the first key is ignored */
+  auto LowerBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int l = PrefixLowerBound(prefix_, 1, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopLowerBound(l, GetSize(), [&](int i) { return cmp(array_[i].first.first, key.first) < 0; });
+  }
+
+  /** @return index of the first key whose first component is greater than key's, the first key is ignored */
   auto UpperBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int {
-    int l = 1;
-    int r = GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (cmp(key.first, array_[mid].first.first) == -1) {
-        r = mid;
-      } else {
-        l = mid + 1;
+    int r = PrefixUpperBound(prefix_, 1, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopUpperBound(1, r, [&](int i) { return cmp(key.first, array_[i].first.first) < 0; });
+  }
+
+ private:
+  // entries that are trivially copyable, such as the ones of every tree in this repo, move with memmove / memcpy
+  static constexpr bool TRIVIAL_ENTRIES = std::is_trivially_copyable_v<MappingType>;
+
+  /** Move n entries from slot src on to slot dst on, the ranges may overlap. */
+  void MoveEntries(int dst, int src, int n) {
+    if constexpr (TRIVIAL_ENTRIES) {
+      std::memmove(array_ + dst, array_ + src, n * sizeof(MappingType));
+    } else if (dst < src) {
+      for (int i = 0; i < n; ++i) {
+        array_[dst + i] = array_[src + i];
+      }
+    } else {
+      for (int i = n - 1; i >= 0; --i) {
+        array_[dst + i] = array_[src + i];
       }
     }
-    return l;
+    std::memmove(prefix_ + dst, prefix_ + src, n * sizeof(int64_t));
   }
 
- private:
+  int32_t padding_;
+  // prefix_[i] is the KeyPrefix of array_[i].first, node searches run on it before they compare keys
+  int64_t prefix_[INTERNAL_PAGE_SIZE + 1];
   // Flexible array member for page data.
   MappingType array_[0];
 };
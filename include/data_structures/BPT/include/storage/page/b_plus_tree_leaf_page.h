@@ -1,13 +1,15 @@
 #pragma once
 
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/key_prefix.h"
 
 namespace CrazyDave {
 
-#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
+#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator, PageSize>
 #define LEAF_PAGE_HEADER_SIZE 16
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType)-1)
 
 /**
  * Store indexed key and record id (record id = page id combined with slot id,
@@ -15,18 +17,24 @@ namespace CrazyDave {
  * page. Only support unique key.
  *
  * Leaf page format (keys are stored in order):
- * -----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)  |
- * -----------------------------------------------------------------------
+ * ----------------------------------------------------------------------------------------------------
+ * | HEADER | PREFIX(1) | ... | PREFIX(n) | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n) |
+ * ----------------------------------------------------------------------------------------------------
+ * PREFIX(i) is the leading integer of KEY(i), see key_prefix.h. The prefixes take room for LEAF_PAGE_SIZE + 1
+ * keys whatever the max size of the page is, so the pairs always start at the same offset.
  *
  * Header format (size in byte, 16 bytes in total):
  * -----------------------------------------------------------------------
  * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) | ... |
  * -----------------------------------------------------------------------
  */
-template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename KeyType, typename ValueType, typename KeyComparator, int PageSize = BUSTUB_PAGE_SIZE>
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
+  /** Number of entries a page of PageSize bytes holds */
+  static constexpr int LEAF_PAGE_SIZE =
+      (PageSize - LEAF_PAGE_HEADER_SIZE) / static_cast<int>(sizeof(MappingType) + sizeof(int64_t)) - 1;
+
   // Delete all constructor / destructor to ensure memory safety
   BPlusTreeLeafPage() = delete;
 
@@ -51,67 +59,116 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   auto KeyAt(int index) const -> KeyType{ return array_[index].first; }
 
-  void SetKeyAt(int index, const KeyType &key) { array_[index].first = key; }
+  void SetKeyAt(int index, const KeyType &key) {
+    array_[index].first = key;
+    prefix_[index] = KeyPrefix<KeyType>::Get(key);
+  }
 
   auto ValueAt(int index) const -> ValueType{ return array_[index].second; }
 
   void InsertAt(int index, const KeyType &key, const ValueType &value){
-    for (int i = GetSize(); i > index; --i) {
-      array_[i] = array_[i - 1];
-    }
+    MoveEntries(index + 1, index, GetSize() - index);
     array_[index].first = key;
     array_[index].second = value;
+    prefix_[index] = KeyPrefix<KeyType>::Get(key);
     IncreaseSize(1);
   }
 
   void RemoveAt(int index){
-    for (int i = index; i < GetSize() - 1; ++i) {
-      array_[i] = array_[i + 1];
-    }
+    MoveEntries(index, index + 1, GetSize() - index - 1);
     IncreaseSize(-1);
   }
 
   auto PairAt(int index) const -> const MappingType &{ return array_[index]; }
 
+  auto SecondAt(int index) const -> const auto & { return array_[index].first.second; }
+
   void InsertAt(int index, const MappingType &_pair) {
-    for (int i = GetSize(); i > index; --i) {
-      array_[i] = array_[i - 1];
-    }
+    MoveEntries(index + 1, index, GetSize() - index);
     array_[index] = _pair;
+    prefix_[index] = KeyPrefix<KeyType>::Get(_pair.first);
     IncreaseSize(1);
   }
 
-  auto LowerBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int{
-    int l = 0;
-    int r = GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (cmp(array_[mid].first.first, key.first) == -1) {
-        l = mid + 1;
-      } else {
-        r = mid;
+  /** Append the entries [begin, end) of src to this page. */
+  void AppendFrom(const BPlusTreeLeafPage *src, int begin, int end) {
+    int n = end - begin;
+    if constexpr (TRIVIAL_ENTRIES) {
+      std::memcpy(array_ + GetSize(), src->array_ + begin, n * sizeof(MappingType));
+    } else {
+      for (int i = 0; i < n; ++i) {
+        array_[GetSize() + i] = src->array_[begin + i];
       }
     }
-    return l;
+    std::memcpy(prefix_ + GetSize(), src->prefix_ + begin, n * sizeof(int64_t));
+    IncreaseSize(n);
   }
 
+  /** @return whether the page reached its max size and has to split */
+  auto IsFull() const -> bool { return GetSize() >= GetMaxSize(); }
+
+  /** @return where a full page splits, the entries from there on move to the new page */
+  auto SplitIndex() const -> int { return GetSize() >> 1; }
+
+  /** @return whether the page fell below its min size and has to borrow or merge */
+  auto IsUnderfull() const -> bool { return GetSize() < GetMinSize(); }
+
+  /** @return whether the page can give an entry to a neighbor and stay at least at its min size */
+  auto CanLend() const -> bool { return GetSize() > GetMinSize(); }
+
+  /** @return whether one more entry leaves the page short of full */
+  auto HasSpareRoom() const -> bool { return GetSize() + 1 < GetMaxSize(); }
 
-  auto UpperBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int{
-    int l = 0;
-    int r = GetSize();
-    while (l < r) {
-      int mid = (l + r) >> 1;
-      if (cmp(key.first, array_[mid].first.first) == -1) {
-        r = mid;
-      } else {
-        l = mid + 1;
+  /** @return whether the entries of src fit in this page without making it full */
+  auto CanMerge(const BPlusTreeLeafPage *src) const -> bool { return GetSize() + src->GetSize() < GetMaxSize(); }
+
+  /** @return index of the first key not less than key */
+  auto LowerBound(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int l = PrefixLowerBound(prefix_, 0, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopLowerBound(l, GetSize(), [&](int i) { return cmp(array_[i].first, key) < 0; });
+  }
+
+  /** @return index of the first key greater than key */
+  auto UpperBound(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int r = PrefixUpperBound(prefix_, 0, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopUpperBound(0, r, [&](int i) { return cmp(key, array_[i].first) < 0; });
+  }
+
+  /** @return index of the first key whose first component is not less than key's */
+  auto LowerBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int l = PrefixLowerBound(prefix_, 0, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopLowerBound(l, GetSize(), [&](int i) { return cmp(array_[i].first.first, key.first) < 0; });
+  }
+
+  /** @return index of the first key whose first component is greater than key's */
+  auto UpperBoundByFirst(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int r = PrefixUpperBound(prefix_, 0, GetSize(), KeyPrefix<KeyType>::Get(key));
+    return GallopUpperBound(0, r, [&](int i) { return cmp(key.first, array_[i].first.first) < 0; });
+  }
+
+ private:
+  // entries that are trivially copyable, such as the ones of every tree in this repo, move with memmove / memcpy
+  static constexpr bool TRIVIAL_ENTRIES = std::is_trivially_copyable_v<MappingType>;
+
+  /** Move n entries from slot src on to slot dst on, the ranges may overlap. */
+  void MoveEntries(int dst, int src, int n) {
+    if constexpr (TRIVIAL_ENTRIES) {
+      std::memmove(array_ + dst, array_ + src, n * sizeof(MappingType));
+    } else if (dst < src) {
+      for (int i = 0; i < n; ++i) {
+        array_[dst + i] = array_[src + i];
+      }
+    } else {
+      for (int i = n - 1; i >= 0; --i) {
+        array_[dst + i] = array_[src + i];
       }
     }
-    return l;
+    std::memmove(prefix_ + dst, prefix_ + src, n * sizeof(int64_t));
   }
 
- private:
   page_id_t next_page_id_;
+  // prefix_[i] is the KeyPrefix of array_[i].first, node searches run on it before they compare keys
+  int64_t prefix_[LEAF_PAGE_SIZE + 1];
   // Flexible array member for page data.
   MappingType array_[0];
 };
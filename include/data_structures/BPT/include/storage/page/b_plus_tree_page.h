@@ -14,6 +14,9 @@ namespace CrazyDave {
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
+// leaf page layout of a B+ tree: Plain stores every key, RunLength stores a run of equal first keys once
+enum class LeafFormat { Plain, RunLength };
+
 /**
  * Both internal and leaf page are inherited from this page.
  *
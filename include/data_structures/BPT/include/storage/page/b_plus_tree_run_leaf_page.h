@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include "storage/page/b_plus_tree_page.h"
+#include "storage/page/key_prefix.h"
+
+namespace CrazyDave {
+
+#define B_PLUS_TREE_RUN_LEAF_PAGE_TYPE BPlusTreeRunLeafPage<KeyType, ValueType, KeyComparator, PageSize>
+#define RUN_LEAF_PAGE_HEADER_SIZE 24
+
+/**
+ * Leaf page of LeafFormat::RunLength. KeyType is a pair with an integral first component, and the entries of a
+ * run of equal first keys keep the first key once, as the prefix of their run. Trees where one first key
+ * carries many values, such as the records of a station, fit more entries in a page this way.
+ *
+ * Run leaf page format (runs and entries are stored in order):
+ * ---------------------------------------------------------------------------------------------------------
+ * | HEADER | PREFIX(1) | ... | PREFIX(m) | END(1) | ... | END(m) | SECOND(1) + RID(1) | ... | SECOND(n) + RID(n) |
+ * ---------------------------------------------------------------------------------------------------------
+ * Run r holds the entries [END(r - 1), END(r)), all with the first key PREFIX(r) stands for, see key_prefix.h.
+ * There is room for RUN_CAPACITY runs, half the max size, so the page fills up by runs before it does by entries
+ * when the runs average less than two entries.
+ *
+ * Header format (size in byte, 24 bytes in total):
+ * ------------------------------------------------------------------------------------------
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) | RunCount (4) | ... (4) |
+ * ------------------------------------------------------------------------------------------
+ *
+ * Searches run on the prefixes of the runs, and within a run KeyComparator::CompareSecond() orders the entries.
+ * Entries are not stored as MappingType, so KeyAt() and PairAt() return copies.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator, int PageSize = BUSTUB_PAGE_SIZE>
+class BPlusTreeRunLeafPage : public BPlusTreePage {
+  using KeyFirst = decltype(KeyType::first);
+  using KeySecond = decltype(KeyType::second);
+  using SlotType = pair<KeySecond, ValueType>;
+  static_assert(std::is_integral_v<KeyFirst>, "runs are keyed by the prefix of an integral first key");
+
+ public:
+  /** Number of entries a page of PageSize bytes holds, the run table takes 12 bytes for every two of them */
+  static constexpr int LEAF_PAGE_SIZE =
+      (PageSize - RUN_LEAF_PAGE_HEADER_SIZE - 12) / static_cast<int>(sizeof(SlotType) + 6);
+  /** Number of runs a page holds, kept even so that the entries are 8-byte aligned */
+  static constexpr int RUN_CAPACITY = (LEAF_PAGE_SIZE / 2 + 1) & ~1;
+
+  BPlusTreeRunLeafPage() = delete;
+
+  BPlusTreeRunLeafPage(const BPlusTreeRunLeafPage &other) = delete;
+
+  void Init(int max_size = LEAF_PAGE_SIZE) {
+    SetPageType(IndexPageType::LEAF_PAGE);
+    BPlusTreePage::SetSize(0);
+    SetNextPageId(INVALID_PAGE_ID);
+    SetMaxSize(max_size);
+    run_count_ = 0;
+  }
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  auto KeyAt(int index) const -> KeyType { return {FirstOfRun(RunOf(index)), slots_[index].first}; }
+
+  auto ValueAt(int index) const -> ValueType { return slots_[index].second; }
+
+  auto SecondAt(int index) const -> const KeySecond & { return slots_[index].first; }
+
+  auto PairAt(int index) const -> MappingType { return {KeyAt(index), slots_[index].second}; }
+
+  /** Keep the first size entries and drop the rest. */
+  void SetSize(int size) {
+    run_count_ = size == 0 ? 0 : RunOf(size - 1) + 1;
+    if (run_count_ > 0) {
+      run_end_[run_count_ - 1] = size;
+    }
+    BPlusTreePage::SetSize(size);
+  }
+
+  /** index must keep the entries sorted, as the bounds below return it */
+  void InsertAt(int index, const KeyType &key, const ValueType &value) {
+    auto prefix = KeyPrefix<KeyFirst>::Get(key.first);
+    int r = PrefixLowerBound(run_prefix_, 0, run_count_, prefix);
+    if (r == run_count_ || run_prefix_[r] != prefix) {
+      std::memmove(run_prefix_ + r + 1, run_prefix_ + r, (run_count_ - r) * sizeof(int64_t));
+      std::memmove(run_end_ + r + 1, run_end_ + r, (run_count_ - r) * sizeof(int32_t));
+      run_prefix_[r] = prefix;
+      run_end_[r] = index;
+      ++run_count_;
+    }
+    for (int i = r; i < run_count_; ++i) {
+      ++run_end_[i];
+    }
+    MoveSlots(index + 1, index, GetSize() - index);
+    slots_[index].first = key.second;
+    slots_[index].second = value;
+    IncreaseSize(1);
+  }
+
+  void InsertAt(int index, const MappingType &_pair) { InsertAt(index, _pair.first, _pair.second); }
+
+  void RemoveAt(int index) {
+    int r = RunOf(index);
+    MoveSlots(index, index + 1, GetSize() - index - 1);
+    for (int i = r; i < run_count_; ++i) {
+      --run_end_[i];
+    }
+    if (run_end_[r] == RunBegin(r)) {
+      std::memmove(run_prefix_ + r, run_prefix_ + r + 1, (run_count_ - r - 1) * sizeof(int64_t));
+      std::memmove(run_end_ + r, run_end_ + r + 1, (run_count_ - r - 1) * sizeof(int32_t));
+      --run_count_;
+    }
+    IncreaseSize(-1);
+  }
+
+  /** Append the entries [begin, end) of src to this page. */
+  void AppendFrom(const BPlusTreeRunLeafPage *src, int begin, int end) {
+    if (begin == end) {
+      return;
+    }
+    int size = GetSize();
+    if constexpr (TRIVIAL_SLOTS) {
+      std::memcpy(slots_ + size, src->slots_ + begin, (end - begin) * sizeof(SlotType));
+    } else {
+      for (int i = begin; i < end; ++i) {
+        slots_[size + i - begin] = src->slots_[i];
+      }
+    }
+    for (int r = src->RunOf(begin); r < src->run_count_ && src->RunBegin(r) < end; ++r) {
+      // the first run of src continues the last run of this page if they share the key
+      if (run_count_ == 0 || run_prefix_[run_count_ - 1] != src->run_prefix_[r]) {
+        run_prefix_[run_count_++] = src->run_prefix_[r];
+      }
+      run_end_[run_count_ - 1] = std::min(src->run_end_[r], end) - begin + size;
+    }
+    IncreaseSize(end - begin);
+  }
+
+  /** @return whether the page reached its max size or filled its run table, and has to split */
+  auto IsFull() const -> bool { return GetSize() >= GetMaxSize() || run_count_ >= RUN_CAPACITY; }
+
+  /** @return where a full page splits. A page full of runs splits between them, so both halves keep half the runs. */
+  auto SplitIndex() const -> int {
+    return run_count_ >= RUN_CAPACITY ? RunBegin(run_count_ >> 1) : GetSize() >> 1;
+  }
+
+  /**
+   * A page holding half its max size or half its run capacity is full enough. Two neighbors below both halves
+   * always fit in one page, so a merge never fails.
+   * @return whether the page has to borrow or merge
+   */
+  auto IsUnderfull() const -> bool { return GetSize() < GetMinSize() && run_count_ < RUN_CAPACITY / 2; }
+
+  /** @return whether the page can give an entry to a neighbor and stay full enough */
+  auto CanLend() const -> bool { return GetSize() > GetMinSize() || run_count_ > RUN_CAPACITY / 2; }
+
+  /** @return whether one more entry, which may start a run, leaves the page short of full */
+  auto HasSpareRoom() const -> bool { return GetSize() + 1 < GetMaxSize() && run_count_ + 1 < RUN_CAPACITY; }
+
+  /** @return whether the entries of src fit in this page without making it full */
+  auto CanMerge(const BPlusTreeRunLeafPage *src) const -> bool {
+    if (src->run_count_ == 0) {
+      return true;
+    }
+    int runs = run_count_ + src->run_count_;
+    if (run_count_ > 0 && run_prefix_[run_count_ - 1] == src->run_prefix_[0]) {
+      --runs;
+    }
+    return GetSize() + src->GetSize() < GetMaxSize() && runs < RUN_CAPACITY;
+  }
+
+  /** @return index of the first key not less than key */
+  auto LowerBound(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int r = FindRun(key.first);
+    if (r == run_count_ || run_prefix_[r] != KeyPrefix<KeyFirst>::Get(key.first)) {
+      return RunBegin(r);
+    }
+    return GallopLowerBound(RunBegin(r), run_end_[r],
+                            [&](int i) { return cmp.CompareSecond(slots_[i].first, key.second) < 0; });
+  }
+
+  /** @return index of the first key greater than key */
+  auto UpperBound(const KeyType &key, const KeyComparator &cmp) const -> int {
+    int r = FindRun(key.first);
+    if (r == run_count_ || run_prefix_[r] != KeyPrefix<KeyFirst>::Get(key.first)) {
+      return RunBegin(r);
+    }
+    return GallopUpperBound(RunBegin(r), run_end_[r],
+                            [&](int i) { return cmp.CompareSecond(key.second, slots_[i].first) < 0; });
+  }
+
+  /** @return index of the first key whose first component is not less than key's */
+  auto LowerBoundByFirst(const KeyType &key, const KeyComparator & /*cmp*/) const -> int {
+    return RunBegin(FindRun(key.first));
+  }
+
+  /** @return index of the first key whose first component is greater than key's */
+  auto UpperBoundByFirst(const KeyType &key, const KeyComparator & /*cmp*/) const -> int {
+    return RunBegin(PrefixUpperBound(run_prefix_, 0, run_count_, KeyPrefix<KeyFirst>::Get(key.first)));
+  }
+
+ private:
+  static constexpr bool TRIVIAL_SLOTS = std::is_trivially_copyable_v<SlotType>;
+
+  auto FindRun(const KeyFirst &first) const -> int {
+    return PrefixLowerBound(run_prefix_, 0, run_count_, KeyPrefix<KeyFirst>::Get(first));
+  }
+
+  auto FirstOfRun(int r) const -> KeyFirst { return KeyPrefix<KeyFirst>::Restore(run_prefix_[r]); }
+
+  auto RunBegin(int r) const -> int { return r == 0 ? 0 : run_end_[r - 1]; }
+
+  /** @return the run holding the entry at index */
+  auto RunOf(int index) const -> int {
+    return static_cast<int>(std::upper_bound(run_end_, run_end_ + run_count_, index) - run_end_);
+  }
+
+  /** Move n entries from slot src on to slot dst on, the ranges may overlap. */
+  void MoveSlots(int dst, int src, int n) {
+    if constexpr (TRIVIAL_SLOTS) {
+      std::memmove(slots_ + dst, slots_ + src, n * sizeof(SlotType));
+    } else if (dst < src) {
+      for (int i = 0; i < n; ++i) {
+        slots_[dst + i] = slots_[src + i];
+      }
+    } else {
+      for (int i = n - 1; i >= 0; --i) {
+        slots_[dst + i] = slots_[src + i];
+      }
+    }
+  }
+
+  page_id_t next_page_id_;
+  int32_t run_count_;
+  int32_t padding_;
+  int64_t run_prefix_[RUN_CAPACITY];
+  int32_t run_end_[RUN_CAPACITY];
+  // Flexible array member for page data.
+  SlotType slots_[0];
+};
+
+}  // namespace CrazyDave
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace CrazyDave {
+
+#define HTABLE_BUCKET_PAGE_METADATA_SIZE 8
+#define HTABLE_BUCKET_ARRAY_SIZE ((BUSTUB_PAGE_SIZE - HTABLE_BUCKET_PAGE_METADATA_SIZE) / sizeof(KeyType))
+
+/**
+ * Last level of the extendible hash table. Entries are kept sorted, so that all entries sharing a first key
+ * form one run and come out in the same order as from a B+ tree leaf.
+ *
+ * Bucket page format:
+ * ------------------------------------------------------------
+ * | CurrentSize (4) | MaxSize (4) | KEY(1) | ... | KEY(n)     |
+ * ------------------------------------------------------------
+ */
+template <typename KeyType, typename KeyComparator>
+class ExtendibleHTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHTableBucketPage() = delete;
+  ExtendibleHTableBucketPage(const ExtendibleHTableBucketPage &other) = delete;
+
+  /**
+   * After creating a new bucket page from buffer pool, must call initialize
+   * method to set default values
+   * @param max_size Max size of the bucket array
+   */
+  void Init(uint32_t max_size = HTABLE_BUCKET_ARRAY_SIZE) {
+    size_ = 0;
+    max_size_ = max_size;
+  }
+
+  auto GetSize() const -> uint32_t { return size_; }
+
+  void SetSize(uint32_t size) { size_ = size; }
+
+  auto IsFull() const -> bool { return size_ == max_size_; }
+
+  auto IsEmpty() const -> bool { return size_ == 0; }
+
+  auto GetMaxSize() const -> uint32_t { return max_size_; }
+
+  auto KeyAt(uint32_t index) const -> const KeyType & { return array_[index]; }
+
+  void SetKeyAt(uint32_t index, const KeyType &key) { array_[index] = key; }
+
+  void InsertAt(uint32_t index, const KeyType &key) {
+    for (uint32_t i = size_; i > index; --i) {
+      array_[i] = array_[i - 1];
+    }
+    array_[index] = key;
+    ++size_;
+  }
+
+  void RemoveAt(uint32_t index) {
+    for (uint32_t i = index; i + 1 < size_; ++i) {
+      array_[i] = array_[i + 1];
+    }
+    --size_;
+  }
+
+  // Append without keeping the order, the caller is copying an already sorted run
+  void PushBack(const KeyType &key) { array_[size_++] = key; }
+
+  auto LowerBound(const KeyType &key, const KeyComparator &cmp) const -> uint32_t {
+    uint32_t l = 0;
+    uint32_t r = size_;
+    while (l < r) {
+      uint32_t mid = (l + r) >> 1;
+      if (cmp(array_[mid], key) == -1) {
+        l = mid + 1;
+      } else {
+        r = mid;
+      }
+    }
+    return l;
+  }
+
+  template <typename KeyFirst>
+  auto LowerBoundByFirst(const KeyFirst &key, const KeyComparator &cmp) const -> uint32_t {
+    uint32_t l = 0;
+    uint32_t r = size_;
+    while (l < r) {
+      uint32_t mid = (l + r) >> 1;
+      if (cmp(array_[mid].first, key) == -1) {
+        l = mid + 1;
+      } else {
+        r = mid;
+      }
+    }
+    return l;
+  }
+
+ private:
+  uint32_t size_;
+  uint32_t max_size_;
+  // Flexible array member for page data.
+  KeyType array_[0];
+};
+
+}  // namespace CrazyDave
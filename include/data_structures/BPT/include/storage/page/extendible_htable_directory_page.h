@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace CrazyDave {
+
+static constexpr uint32_t HTABLE_DIRECTORY_PAGE_METADATA_SIZE = sizeof(uint32_t) * 2;
+static constexpr uint32_t HTABLE_DIRECTORY_MAX_DEPTH = 11;
+static constexpr uint32_t HTABLE_DIRECTORY_ARRAY_SIZE = 1 << HTABLE_DIRECTORY_MAX_DEPTH;
+
+/**
+ * Second level of the extendible hash table. The low global_depth bits of a hash select a slot, and every
+ * slot points to a bucket page. A bucket with local depth d is shared by the 2^(global_depth - d) slots
+ * that agree on the low d bits.
+ *
+ * Directory page format:
+ * --------------------------------------------------------------------------------------
+ * | MaxDepth (4) | GlobalDepth (4) | LocalDepths (1 * 2^MaxDepth) | BucketPageIds (4 * 2^MaxDepth) |
+ * --------------------------------------------------------------------------------------
+ */
+class ExtendibleHTableDirectoryPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHTableDirectoryPage() = delete;
+  ExtendibleHTableDirectoryPage(const ExtendibleHTableDirectoryPage &other) = delete;
+
+  /**
+   * After creating a new directory page from buffer pool, must call initialize
+   * method to set default values
+   * @param max_depth Max depth in the directory page
+   */
+  void Init(uint32_t max_depth = HTABLE_DIRECTORY_MAX_DEPTH);
+
+  /**
+   * @return the bucket index that the hash is mapped to
+   */
+  auto HashToBucketIndex(uint64_t hash) const -> uint32_t;
+
+  auto GetBucketPageId(uint32_t bucket_idx) const -> page_id_t;
+
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /**
+   * @return the index that differs from bucket_idx only in the highest bit of its local depth
+   */
+  auto GetSplitImageIndex(uint32_t bucket_idx) const -> uint32_t;
+
+  auto GetGlobalDepthMask() const -> uint32_t;
+
+  auto GetLocalDepthMask(uint32_t bucket_idx) const -> uint32_t;
+
+  auto GetGlobalDepth() const -> uint32_t;
+
+  auto GetMaxDepth() const -> uint32_t;
+
+  /**
+   * Double the directory, the new upper half mirrors the lower half.
+   */
+  void IncrGlobalDepth();
+
+  void DecrGlobalDepth();
+
+  /**
+   * @return true if every local depth is below the global depth, so the directory can be halved
+   */
+  auto CanShrink() const -> bool;
+
+  /**
+   * @return the number of slots in use, i.e. 2^global_depth
+   */
+  auto Size() const -> uint32_t;
+
+  auto MaxSize() const -> uint32_t;
+
+  auto GetLocalDepth(uint32_t bucket_idx) const -> uint32_t;
+
+  void SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth);
+
+ private:
+  uint32_t max_depth_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[HTABLE_DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[HTABLE_DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(page_id_t) == 4);
+static_assert(sizeof(ExtendibleHTableDirectoryPage) == HTABLE_DIRECTORY_PAGE_METADATA_SIZE +
+                                                           HTABLE_DIRECTORY_ARRAY_SIZE +
+                                                           sizeof(page_id_t) * HTABLE_DIRECTORY_ARRAY_SIZE);
+static_assert(sizeof(ExtendibleHTableDirectoryPage) <= BUSTUB_PAGE_SIZE);
+
+}  // namespace CrazyDave
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace CrazyDave {
+
+static constexpr uint32_t HTABLE_HEADER_PAGE_METADATA_SIZE = sizeof(uint32_t);
+static constexpr uint32_t HTABLE_HEADER_MAX_DEPTH = 9;
+static constexpr uint32_t HTABLE_HEADER_ARRAY_SIZE = 1 << HTABLE_HEADER_MAX_DEPTH;
+
+/**
+ * First level of the extendible hash table. The top max_depth bits of a hash select one of the directories.
+ *
+ * Header page format:
+ * ---------------------------------------------------
+ * | MaxDepth (4) | DirectoryPageIds (4 * 2^MaxDepth) |
+ * ---------------------------------------------------
+ */
+class ExtendibleHTableHeaderPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  ExtendibleHTableHeaderPage() = delete;
+  ExtendibleHTableHeaderPage(const ExtendibleHTableHeaderPage &other) = delete;
+
+  /**
+   * After creating a new header page from buffer pool, must call initialize
+   * method to set default values
+   * @param max_depth Max depth in the header page
+   */
+  void Init(uint32_t max_depth = HTABLE_HEADER_MAX_DEPTH);
+
+  /**
+   * @return the directory index that the hash is mapped to
+   */
+  auto HashToDirectoryIndex(uint64_t hash) const -> uint32_t;
+
+  auto GetDirectoryPageId(uint32_t directory_idx) const -> page_id_t;
+
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  /**
+   * @return the number of directories the header page can handle
+   */
+  auto MaxSize() const -> uint32_t;
+
+ private:
+  uint32_t max_depth_;
+  page_id_t directory_page_ids_[HTABLE_HEADER_ARRAY_SIZE];
+};
+
+static_assert(sizeof(page_id_t) == 4);
+static_assert(sizeof(ExtendibleHTableHeaderPage) ==
+              sizeof(page_id_t) * HTABLE_HEADER_ARRAY_SIZE + HTABLE_HEADER_PAGE_METADATA_SIZE);
+static_assert(sizeof(ExtendibleHTableHeaderPage) <= BUSTUB_PAGE_SIZE);
+
+}  // namespace CrazyDave
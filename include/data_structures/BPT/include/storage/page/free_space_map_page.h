@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace CrazyDave {
+
+static constexpr page_id_t FSM_META_PAGE_ID = 1;          // page 0 is left to the index header
+static constexpr page_id_t FSM_FIRST_BITMAP_PAGE_ID = 2;  // bitmap page k lives at k * FSM_BITMAP_PAGE_BITS + 2
+static constexpr uint32_t FSM_META_PAGE_METADATA_SIZE = 16;
+static constexpr uint32_t FSM_BITMAP_PAGE_BITS = MIN_PAGE_SIZE * 8;
+static constexpr uint32_t FSM_SUMMARY_WORDS = (MIN_PAGE_SIZE - FSM_META_PAGE_METADATA_SIZE) / sizeof(uint64_t);
+
+/**
+ * Root of the free space map of a data file. The map only uses the first MIN_PAGE_SIZE bytes of its pages, so its
+ * layout is the same whatever page size the file was created with.
+ *
+ * Meta page format:
+ * ------------------------------------------------------------------------------
+ * | NextPageId (4) | FreeCount (4) | Hint (4) | Reserved (4) | Summary (8 * n) |
+ * ------------------------------------------------------------------------------
+ * NextPageId is the first page id never handed out, the file spans the pages below it. Bit k of Summary is set
+ * while bitmap page k has a free page, and no bitmap page below Hint has one.
+ */
+class FreeSpaceMetaPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  FreeSpaceMetaPage() = delete;
+  FreeSpaceMetaPage(const FreeSpaceMetaPage &other) = delete;
+
+  page_id_t next_page_id_;
+  uint32_t free_count_;
+  uint32_t hint_;
+  uint32_t reserved_;
+  uint64_t summary_[FSM_SUMMARY_WORDS];
+};
+
+/**
+ * One bit per page of a range of FSM_BITMAP_PAGE_BITS pages, set if the page is free. The bitmap page itself and
+ * the pages that were never handed out are not free.
+ */
+class FreeSpaceBitmapPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  FreeSpaceBitmapPage() = delete;
+  FreeSpaceBitmapPage(const FreeSpaceBitmapPage &other) = delete;
+
+  uint64_t bits_[FSM_BITMAP_PAGE_BITS / 64];
+};
+
+static_assert(sizeof(FreeSpaceMetaPage) == MIN_PAGE_SIZE);
+static_assert(sizeof(FreeSpaceBitmapPage) == MIN_PAGE_SIZE);
+
+}  // namespace CrazyDave
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#include "common/utils.hpp"
+
+namespace CrazyDave {
+
+static constexpr int PREFIX_SCAN_WINDOW = 16;  // prefixes left to the vector scan once the binary search narrowed in
+
+/**
+ * KeyPrefix<T>::Get(key) maps the leading integer of a B+ tree key to an int64_t that orders the same way. Pages
+ * keep the prefixes of their keys in an array of their own and search it first, the comparator only runs on the
+ * keys whose prefixes tie.
+ */
+template <class T>
+struct KeyPrefix;
+
+template <std::integral T>
+struct KeyPrefix<T> {
+  static auto Get(const T &key) -> int64_t {
+    if constexpr (std::is_signed_v<T>) {
+      return key;
+    } else {
+      // flip the sign bit so that signed compares order unsigned keys
+      return static_cast<int64_t>(static_cast<uint64_t>(key) ^ (uint64_t{1} << 63));
+    }
+  }
+  // the key Get() was called on, for pages that keep the prefix in place of the key
+  static auto Restore(int64_t prefix) -> T {
+    if constexpr (std::is_signed_v<T>) {
+      return static_cast<T>(prefix);
+    } else {
+      return static_cast<T>(static_cast<uint64_t>(prefix) ^ (uint64_t{1} << 63));
+    }
+  }
+};
+
+template <class T1, class T2>
+struct KeyPrefix<pair<T1, T2>> {
+  static auto Get(const pair<T1, T2> &key) -> int64_t { return KeyPrefix<T1>::Get(key.first); }
+};
+
+/**
+ * @return the first index in [l, r) of the sorted prefixes whose prefix is not less than (UPPER: greater than)
+ * prefix, r if there is none
+ */
+template <bool UPPER>
+auto PrefixBound(const int64_t *prefixes, int l, int r, int64_t prefix) -> int {
+  auto before = [prefix](int64_t x) { return UPPER ? x <= prefix : x < prefix; };
+  while (r - l > PREFIX_SCAN_WINDOW) {
+    int mid = (l + r) >> 1;
+    if (before(prefixes[mid])) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  // the window is sorted, the bound is l plus the number of prefixes in it that come before prefix
+  int i = l;
+  int count = 0;
+#if defined(__AVX2__)
+  auto key = _mm256_set1_epi64x(prefix);
+  for (; i + 4 <= r; i += 4) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prefixes + i));
+    auto gt = UPPER ? _mm256_cmpgt_epi64(x, key) : _mm256_cmpgt_epi64(key, x);
+    int n = std::popcount(static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(gt))));
+    count += UPPER ? 4 - n : n;
+  }
+#elif defined(__SSE4_2__)
+  auto key = _mm_set1_epi64x(prefix);
+  for (; i + 2 <= r; i += 2) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prefixes + i));
+    auto gt = UPPER ? _mm_cmpgt_epi64(x, key) : _mm_cmpgt_epi64(key, x);
+    int n = std::popcount(static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(gt))));
+    count += UPPER ? 2 - n : n;
+  }
+#endif
+  for (; i < r; ++i) {
+    count += before(prefixes[i]) ? 1 : 0;
+  }
+  return l + count;
+}
+
+inline auto PrefixLowerBound(const int64_t *prefixes, int l, int r, int64_t prefix) -> int {
+  return PrefixBound<false>(prefixes, l, r, prefix);
+}
+
+inline auto PrefixUpperBound(const int64_t *prefixes, int l, int r, int64_t prefix) -> int {
+  return PrefixBound<true>(prefixes, l, r, prefix);
+}
+
+/**
+ * Break a prefix tie: gallop right from l, then binary search.
+ * @return the first index in [l, r) where before(index) is false, r if there is none
+ */
+template <class Before>
+auto GallopLowerBound(int l, int r, Before &&before) -> int {
+  for (int step = 1; l < r; step <<= 1) {
+    int probe = std::min(r - 1, l + step - 1);
+    if (!before(probe)) {
+      r = probe;
+      break;
+    }
+    l = probe + 1;
+  }
+  while (l < r) {
+    int mid = (l + r) >> 1;
+    if (before(mid)) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return l;
+}
+
+/**
+ * Break a prefix tie: gallop left from r, then binary search.
+ * @return the first index in [l, r) where after(index) is true, r if there is none
+ */
+template <class After>
+auto GallopUpperBound(int l, int r, After &&after) -> int {
+  for (int step = 1; l < r; step <<= 1) {
+    int probe = std::max(l, r - step);
+    if (!after(probe)) {
+      l = probe + 1;
+      break;
+    }
+    r = probe;
+  }
+  while (l < r) {
+    int mid = (l + r) >> 1;
+    if (after(mid)) {
+      r = mid;
+    } else {
+      l = mid + 1;
+    }
+  }
+  return r;
+}
+
+}  // namespace CrazyDave
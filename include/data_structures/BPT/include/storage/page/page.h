@@ -18,16 +18,11 @@ class Page {
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() {
-    //    data_ = new char[BUSTUB_PAGE_SIZE]{};
-    //    ResetMemory();
-  }
+  /** Constructor. The buffer pool points the page at its frame of the pool's memory. */
+  Page() = default;
 
   /** Default destructor. */
-  ~Page() {
-    //    delete[] data_;
-  }
+  ~Page() = default;
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
@@ -59,11 +54,8 @@ class Page {
   static constexpr size_t OFFSET_PAGE_START = 0;
 
  private:
-  /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
-
-  /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
+  /** The actual data that is stored within a page, page size bytes owned by the buffer pool. */
+  char *data_{nullptr};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -0,0 +1,179 @@
+#include "buffer/arc_replacer.h"
+#include <algorithm>
+
+namespace CrazyDave {
+
+ArcReplacer::ArcReplacer(size_t num_frames)
+    : capacity_(num_frames),
+      t1_(num_frames),
+      t2_(num_frames),
+      page_ids_(new page_id_t[num_frames]),
+      evictable_(new bool[num_frames]{}),
+      cold_(new bool[num_frames]{}) {}
+
+ArcReplacer::~ArcReplacer() {
+  delete[] page_ids_;
+  delete[] evictable_;
+  delete[] cold_;
+}
+
+auto ArcReplacer::FirstEvictable(const FrameList &list) const -> frame_id_t {
+  for (auto fid = list.Front(); fid != -1; fid = list.Next(fid)) {
+    if (evictable_[fid] && !cold_[fid]) {
+      return fid;
+    }
+  }
+  return -1;
+}
+
+void ArcReplacer::TrimGhosts() {
+  while (!b1_.empty() && t1_.Size() + b1_.size() > capacity_) {
+    b1_.erase(b1_.begin());
+  }
+  while (b1_.size() + b2_.size() > capacity_) {
+    if (!b2_.empty()) {
+      b2_.erase(b2_.begin());
+    } else {
+      b1_.erase(b1_.begin());
+    }
+  }
+}
+
+auto ArcReplacer::Evict(frame_id_t *frame_id) -> bool {
+  frame_id_t victim = -1;
+  for (auto fid = t1_.Front(); fid != -1 && cold_[fid]; fid = t1_.Next(fid)) {
+    if (evictable_[fid]) {
+      victim = fid;
+      break;
+    }
+  }
+  if (victim == -1 && t1_.Size() > p_) {
+    victim = FirstEvictable(t1_);
+  }
+  if (victim == -1) {
+    victim = FirstEvictable(t2_);
+  }
+  if (victim == -1) {
+    victim = FirstEvictable(t1_);
+  }
+  if (victim == -1) {
+    return false;
+  }
+  if (t1_.Contains(victim)) {
+    t1_.Erase(victim);
+    if (!cold_[victim]) {
+      b1_.insert({page_ids_[victim], true});
+    }
+  } else {
+    t2_.Erase(victim);
+    b2_.insert({page_ids_[victim], true});
+  }
+  TrimGhosts();
+  evictable_[victim] = false;
+  cold_[victim] = false;
+  --curr_size_;
+  *frame_id = victim;
+  return true;
+}
+
+void ArcReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  bool tracked = t1_.Contains(frame_id) || t2_.Contains(frame_id);
+  if (access_type == AccessType::Scan) {
+    if (!tracked) {
+      RecordPrefetch(frame_id);
+    }
+    return;
+  }
+  if (tracked && !cold_[frame_id]) {
+    // a hit, the page has now been seen at least twice
+    if (t1_.Contains(frame_id)) {
+      t1_.Erase(frame_id);
+    } else {
+      t2_.Erase(frame_id);
+    }
+    t2_.PushBack(frame_id);
+    return;
+  }
+  // first real access to the page in this frame
+  if (tracked) {
+    t1_.Erase(frame_id);
+  }
+  cold_[frame_id] = false;
+  page_ids_[frame_id] = page_id;
+  auto it = b1_.find(page_id);
+  if (it != b1_.end()) {
+    p_ = std::min(capacity_, p_ + std::max(b2_.size() / b1_.size(), static_cast<size_t>(1)));
+    b1_.erase(it);
+    t2_.PushBack(frame_id);
+    return;
+  }
+  it = b2_.find(page_id);
+  if (it != b2_.end()) {
+    auto delta = std::max(b1_.size() / b2_.size(), static_cast<size_t>(1));
+    p_ = p_ > delta ? p_ - delta : 0;
+    b2_.erase(it);
+    t2_.PushBack(frame_id);
+    return;
+  }
+  t1_.PushBack(frame_id);
+  TrimGhosts();
+}
+
+void ArcReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (t1_.Contains(frame_id)) {
+    t1_.Erase(frame_id);
+  } else if (t2_.Contains(frame_id)) {
+    t2_.Erase(frame_id);
+  }
+  t1_.PushFront(frame_id);
+  cold_[frame_id] = true;
+}
+
+auto ArcReplacer::GetVictims(frame_id_t *frames, size_t n) -> size_t {
+  size_t cnt = 0;
+  for (auto fid = t1_.Front(); fid != -1 && cold_[fid] && cnt < n; fid = t1_.Next(fid)) {
+    if (evictable_[fid]) {
+      frames[cnt++] = fid;
+    }
+  }
+  bool t1_first = t1_.Size() > p_;
+  const FrameList *order[2] = {t1_first ? &t1_ : &t2_, t1_first ? &t2_ : &t1_};
+  for (auto *list : order) {
+    for (auto fid = list->Front(); fid != -1 && cnt < n; fid = list->Next(fid)) {
+      if (evictable_[fid] && !cold_[fid]) {
+        frames[cnt++] = fid;
+      }
+    }
+  }
+  return cnt;
+}
+
+void ArcReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (evictable_[frame_id] != set_evictable) {
+    if (set_evictable) {
+      ++curr_size_;
+    } else {
+      --curr_size_;
+    }
+  }
+  evictable_[frame_id] = set_evictable;
+}
+
+void ArcReplacer::Remove(frame_id_t frame_id) {
+  if (t1_.Contains(frame_id)) {
+    t1_.Erase(frame_id);
+  } else if (t2_.Contains(frame_id)) {
+    t2_.Erase(frame_id);
+  } else {
+    return;
+  }
+  if (evictable_[frame_id]) {
+    --curr_size_;
+  }
+  evictable_[frame_id] = false;
+  cold_[frame_id] = false;
+}
+
+auto ArcReplacer::Size() -> size_t { return curr_size_; }
+
+}  // namespace CrazyDave
@@ -1,82 +1,205 @@
 #include "buffer/buffer_pool_manager.h"
+#include <algorithm>
+#include <cstring>
 #include "storage/page/page_guard.h"
 
 namespace CrazyDave {
 
-BufferPoolManager::BufferPoolManager(const std::string &name, size_t pool_size, size_t replacer_k)
-    : pool_size_(pool_size) {
+BufferPoolManager::BufferPoolManager(const std::string &name, size_t pool_size, size_t replacer_k,
+                                     ReplacerType replacer_type, int page_size)
+    : pool_size_(pool_size), page_size_(std::max(page_size, MIN_PAGE_SIZE)), page_table_(pool_size) {
   // we allocate a consecutive memory space for the buffer pool
-  disk_manager_ = new MyDiskManager{name};
+  disk_manager_ = new MyDiskManager{name, page_size_};
+  disk_scheduler_ = new DiskScheduler{disk_manager_};
   pages_ = new Page[pool_size_];
-  replacer_ = new LRUKReplacer{pool_size, replacer_k};
+  page_data_ = new char[pool_size_ * page_size_]{};
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = page_data_ + i * page_size_;
+  }
+  replacer_ = MakeReplacer(replacer_type, pool_size, replacer_k);
+  io_tickets_ = new size_t[pool_size_]{};
+  prefetched_ = new bool[pool_size_]{};
+  max_prefetched_ = std::max(pool_size_ / 4, static_cast<size_t>(1));
+  flush_low_watermark_ = std::max(pool_size_ / FLUSH_WATERMARK_DIV, static_cast<size_t>(1));
+  flush_frames_ = new frame_id_t[std::min(2 * flush_low_watermark_, pool_size_)];
+  scan_ring_size_ = std::min(static_cast<size_t>(SCAN_RING_SIZE), pool_size_);
+  scan_ring_ = new frame_id_t[scan_ring_size_];
+  std::fill(scan_ring_, scan_ring_ + scan_ring_size_, -1);
+  scan_frames_ = new bool[pool_size_]{};
+
+#ifdef BPM_TRACE
+  trace_ = new std::ofstream{name + "_trace", std::ios::binary | std::ios::app};
+  Trace(TraceEvent::Open, static_cast<page_id_t>(pool_size_));
+#endif
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.push_back(static_cast<int>(i));
   }
+  if (IsNew()) {
+    free_space_map_.Init();
+  }
 }
 
 BufferPoolManager::~BufferPoolManager() {
+  // the retired pages go back to the free space map before it is written out
+  epochs_.Drain([this](const RetiredPage &retired) { Reclaim(retired); });
   FlushAllPages();
+  delete trace_;
+  delete disk_scheduler_;
   delete[] pages_;
+  delete[] page_data_;
+  delete[] io_tickets_;
+  delete[] prefetched_;
+  delete[] flush_frames_;
+  delete[] scan_ring_;
+  delete[] scan_frames_;
   delete replacer_;
   delete disk_manager_;
 }
 
-auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
-  frame_id_t fid;
-  if (!free_list_.empty()) {
+auto BufferPoolManager::AcquireFrame(frame_id_t *frame_id, AccessType access_type) -> bool {
+  frame_id_t fid = -1;
+  if (access_type == AccessType::Scan) {
+    fid = scan_ring_[scan_ring_pos_];
+  }
+  if (fid != -1 && scan_frames_[fid] && pages_[fid].GetPinCount() == 0) {
+    // recycle the frame this slot of the ring was given last time
+    replacer_->Remove(fid);
+    EvictFrame(fid);
+  } else if (!free_list_.empty()) {
     fid = free_list_.front();
     free_list_.pop_front();
+  } else if (replacer_->Evict(&fid)) {
+    EvictFrame(fid);
+    FlushColdPages();
   } else {
-    if (replacer_->Evict(&fid)) {
-      if (pages_[fid].IsDirty()) {
-        disk_manager_->WritePage(pages_[fid].page_id_, pages_[fid].GetData());
-        pages_[fid].is_dirty_ = false;
-      }
-      page_table_.erase(page_table_.find(pages_[fid].page_id_));
-    } else {
-      return nullptr;
+    return false;
+  }
+  scan_frames_[fid] = access_type == AccessType::Scan;
+  if (access_type == AccessType::Scan) {
+    scan_ring_[scan_ring_pos_] = fid;
+    scan_ring_pos_ = (scan_ring_pos_ + 1) % scan_ring_size_;
+  }
+  *frame_id = fid;
+  return true;
+}
+
+void BufferPoolManager::EvictFrame(frame_id_t frame_id) {
+  auto &frame = pages_[frame_id];
+  ++stats_.evictions_;
+  WaitForFrame(frame_id);
+  if (prefetched_[frame_id]) {
+    prefetched_[frame_id] = false;
+    --prefetched_count_;
+  }
+  if (frame.IsDirty()) {
+    disk_manager_->WritePage(frame.page_id_, frame.GetData());
+    frame.is_dirty_ = false;
+    ++stats_.dirty_writes_;
+    ++stats_.write_stalls_;
+  }
+  page_table_.Erase(frame.page_id_);
+}
+
+void BufferPoolManager::Trace(TraceEvent event, page_id_t page_id, AccessType access_type) {
+  if (trace_ != nullptr) {
+    TraceRecord record{event, access_type, page_id};
+    trace_->write(reinterpret_cast<const char *>(&record), sizeof(record));
+  }
+}
+
+void BufferPoolManager::WaitForFrame(frame_id_t frame_id) {
+  if (io_tickets_[frame_id] != 0) {
+    if (!disk_scheduler_->IsDone(io_tickets_[frame_id])) {
+      ++stats_.io_waits_;
+      disk_scheduler_->Wait(io_tickets_[frame_id]);
     }
+    io_tickets_[frame_id] = 0;
+  }
+}
+
+void BufferPoolManager::FlushColdPages() {
+  auto n = replacer_->GetVictims(flush_frames_, std::min(2 * flush_low_watermark_, pool_size_));
+  bool need_flush = false;
+  for (size_t i = 0; i < n && i < flush_low_watermark_; ++i) {
+    need_flush |= pages_[flush_frames_[i]].IsDirty();
+  }
+  if (!need_flush) {
+    return;
+  }
+  size_t cnt = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (pages_[flush_frames_[i]].IsDirty()) {
+      flush_frames_[cnt++] = flush_frames_[i];
+    }
+  }
+  for (size_t i = 1; i < cnt; ++i) {
+    auto fid = flush_frames_[i];
+    size_t j = i;
+    for (; j > 0 && pages_[flush_frames_[j - 1]].page_id_ > pages_[fid].page_id_; --j) {
+      flush_frames_[j] = flush_frames_[j - 1];
+    }
+    flush_frames_[j] = fid;
+  }
+  for (size_t i = 0; i < cnt; ++i) {
+    auto &frame = pages_[flush_frames_[i]];
+    io_tickets_[flush_frames_[i]] = disk_scheduler_->Schedule({true, frame.GetData(), frame.page_id_});
+    frame.is_dirty_ = false;
+    ++stats_.flushed_pages_;
+    if (i == 0 || pages_[flush_frames_[i - 1]].page_id_ + 1 != frame.page_id_) {
+      ++stats_.flush_batches_;
+    }
+  }
+}
+
+auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
+  ++stats_.new_pages_;
+  // take the page id first, the free space map fetches its own pages
+  auto pid = free_space_map_.AllocatePage();
+  frame_id_t fid;
+  if (!AcquireFrame(&fid)) {
+    free_space_map_.DeallocatePage(pid);
+    return nullptr;
   }
-  auto pid = disk_manager_->AllocatePage();
   auto &frame = pages_[fid];
   frame.page_id_ = pid;
   frame.pin_count_ = 0;
   frame.is_dirty_ = false;
-  page_table_[pid] = fid;
+  page_table_.Insert(pid, fid);
   *page_id = pid;
-  replacer_->RecordAccess(fid);
+  Trace(TraceEvent::New, pid);
+  replacer_->RecordAccess(fid, pid);
   replacer_->SetEvictable(fid, false);
   ++pages_[fid].pin_count_;
   return &pages_[fid];
 }
 
-auto BufferPoolManager::FetchPage(page_id_t page_id) -> Page * {
-  auto it = page_table_.find(page_id);
-  if (it != page_table_.end()) {
-    auto fid = it->second;
+auto BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) -> Page * {
+  ++stats_.fetches_;
+  Trace(TraceEvent::Fetch, page_id, access_type);
+  auto fid = page_table_.Find(page_id);
+  if (fid != -1) {
+    ++stats_.hits_;
     auto &frame = pages_[fid];
+    WaitForFrame(fid);
+    if (prefetched_[fid]) {
+      prefetched_[fid] = false;
+      --prefetched_count_;
+      ++stats_.prefetch_hits_;
+    }
+    if (access_type != AccessType::Scan) {
+      // the working set wants this page too, keep it out of the ring
+      scan_frames_[fid] = false;
+    }
     ++frame.pin_count_;
-    replacer_->RecordAccess(fid);
+    replacer_->RecordAccess(fid, page_id, access_type);
     replacer_->SetEvictable(fid, false);
     return &frame;
   }
   // Not found in buffer pool. Read from the disk.
-  frame_id_t fid;
-  if (!free_list_.empty()) {
-    fid = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    if (replacer_->Evict(&fid)) {
-      if (pages_[fid].IsDirty()) {
-        disk_manager_->WritePage(pages_[fid].page_id_, pages_[fid].GetData());
-        pages_[fid].is_dirty_ = false;
-      }
-      page_table_.erase(page_table_.find(pages_[fid].page_id_));
-    } else {
-      return nullptr;
-    }
+  if (!AcquireFrame(&fid, access_type)) {
+    return nullptr;
   }
   auto &frame = pages_[fid];
 
@@ -84,19 +207,42 @@ auto BufferPoolManager::FetchPage(page_id_t page_id) -> Page * {
   frame.pin_count_ = 1;
   frame.is_dirty_ = false;
 
-  page_table_[page_id] = fid;
+  page_table_.Insert(page_id, fid);
   disk_manager_->ReadPage(page_id, frame.GetData());
-  replacer_->RecordAccess(fid);
+  ++stats_.misses_;
+  replacer_->RecordAccess(fid, page_id, access_type);
   replacer_->SetEvictable(fid, false);
   return &frame;
 }
 
+void BufferPoolManager::PrefetchPage(page_id_t page_id, AccessType access_type) {
+  if (page_id == INVALID_PAGE_ID || prefetched_count_ >= max_prefetched_ ||
+      page_table_.Find(page_id) != -1) {
+    return;
+  }
+  frame_id_t fid;
+  if (!AcquireFrame(&fid, access_type)) {
+    return;
+  }
+  Trace(TraceEvent::Prefetch, page_id, access_type);
+  auto &frame = pages_[fid];
+  frame.page_id_ = page_id;
+  frame.pin_count_ = 0;
+  frame.is_dirty_ = false;
+  page_table_.Insert(page_id, fid);
+  io_tickets_[fid] = disk_scheduler_->Schedule({false, frame.GetData(), page_id});
+  prefetched_[fid] = true;
+  ++prefetched_count_;
+  ++stats_.prefetches_;
+  replacer_->RecordPrefetch(fid);
+  replacer_->SetEvictable(fid, true);
+}
+
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) -> bool {
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end() || pages_[it->second].pin_count_ == 0) {
+  auto fid = page_table_.Find(page_id);
+  if (fid == -1 || pages_[fid].pin_count_ == 0) {
     return false;
   }
-  auto fid = it->second;
   auto &frame = pages_[fid];
   --frame.pin_count_;
   if (frame.pin_count_ == 0) {
@@ -112,20 +258,22 @@ auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
+  auto fid = page_table_.Find(page_id);
+  if (fid == -1) {
     return false;
   }
-  auto fid = it->second;
   auto &frame = pages_[fid];
+  WaitForFrame(fid);
   disk_manager_->WritePage(page_id, frame.GetData());
   frame.is_dirty_ = false;
   return true;
 }
 
 void BufferPoolManager::FlushAllPages() {
-  for (auto &pr : page_table_) {
-    FlushPage(pr.first);
+  for (size_t i = 0; i < pool_size_; ++i) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID) {
+      FlushPage(pages_[i].page_id_);
+    }
   }
 }
 
@@ -133,43 +281,130 @@ auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
+  if (!epochs_.HasReaders()) {
+    return FreePage(page_id);
+  }
+  // an open snapshot may still reach the page, leave it as it is until the snapshot closes
+  auto fid = page_table_.Find(page_id);
+  if (fid != -1 && pages_[fid].GetPinCount() > 0) {
+    return false;
+  }
+  epochs_.Retire({page_id, nullptr});
+  ++stats_.retired_pages_;
+  return true;
+}
+
+auto BufferPoolManager::FreePage(page_id_t page_id) -> bool {
+  auto fid = page_table_.Find(page_id);
+  if (fid == -1) {
+    free_space_map_.DeallocatePage(page_id);
+    ++stats_.deleted_pages_;
     return true;
   }
-  auto fid = it->second;
   auto &frame = pages_[fid];
   if (frame.GetPinCount() > 0) {
     return false;
   }
-  if (frame.IsDirty()) {
-    disk_manager_->WritePage(page_id, frame.GetData());
-    frame.is_dirty_ = false;
+  WaitForFrame(fid);
+  if (prefetched_[fid]) {
+    prefetched_[fid] = false;
+    --prefetched_count_;
   }
-  page_table_.erase(it);
+  // the page is free from now on, nobody reads what it held
+  Trace(TraceEvent::Delete, page_id);
+  page_table_.Erase(page_id);
+  scan_frames_[fid] = false;
   replacer_->Remove(fid);
   free_list_.push_back(fid);
   //  frame.ResetMemory();
   frame.pin_count_ = 0;
   frame.page_id_ = INVALID_PAGE_ID;
   frame.is_dirty_ = false;
-  disk_manager_->DeallocatePage(page_id);
+  free_space_map_.DeallocatePage(page_id);
+  ++stats_.deleted_pages_;
   // latch_.unlock();
   return true;
 }
 
-auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard { return {this, FetchPage(page_id)}; }
+auto BufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  return {this, FetchPage(page_id, access_type)};
+}
 
-auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
-  Page *page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  Page *page = FetchPage(page_id, access_type);
   return {this, page};
 }
 
-auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
-  Page *page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  Page *page = FetchPage(page_id, access_type);
+  if (epochs_.HasReaders() && page != nullptr) {
+    PreserveVersion(page_id, page->GetData());
+  }
   return {this, page};
 }
 
+auto BufferPoolManager::BeginSnapshot() -> uint64_t { return epochs_.Enter(); }
+
+void BufferPoolManager::EndSnapshot(uint64_t snapshot) {
+  epochs_.Exit(snapshot);
+  epochs_.Collect([this](const RetiredPage &retired) { Reclaim(retired); });
+}
+
+auto BufferPoolManager::FetchPageSnapshot(page_id_t page_id, uint64_t snapshot, AccessType access_type)
+    -> ReadPageGuard {
+  auto it = versions_.find(page_id);
+  if (it != versions_.end()) {
+    // the oldest copy made after the snapshot was taken holds the page as the snapshot saw it
+    PageVersion *seen = nullptr;
+    for (auto *version = it->second; version != nullptr && version->epoch_ > snapshot; version = version->older_) {
+      seen = version;
+    }
+    if (seen != nullptr) {
+      return {nullptr, &seen->page_};
+    }
+  }
+  return FetchPageRead(page_id, access_type);
+}
+
+void BufferPoolManager::PreserveVersion(page_id_t page_id, const char *data) {
+  auto it = versions_.find(page_id);
+  PageVersion *newest = it == versions_.end() ? nullptr : it->second;
+  if (newest != nullptr && newest->epoch_ > epochs_.GetNewestReader()) {
+    return;  // every open snapshot reads newest or an older copy
+  }
+  auto *version = new PageVersion{epochs_.GetEpoch(), {}, newest};
+  version->page_.data_ = new char[page_size_];
+  version->page_.page_id_ = page_id;
+  std::memcpy(version->page_.data_, data, page_size_);
+  if (newest == nullptr) {
+    versions_.insert({page_id, version});
+  } else {
+    it->second = version;
+  }
+  epochs_.Retire({page_id, version});
+  ++stats_.page_versions_;
+}
+
+void BufferPoolManager::Reclaim(const RetiredPage &retired) {
+  if (retired.version_ == nullptr) {
+    FreePage(retired.page_id_);
+    return;
+  }
+  // copies are retired oldest first, so this one ends its chain
+  auto it = versions_.find(retired.page_id_);
+  if (it->second == retired.version_) {
+    versions_.erase(it);
+  } else {
+    auto *newer = it->second;
+    while (newer->older_ != retired.version_) {
+      newer = newer->older_;
+    }
+    newer->older_ = nullptr;
+  }
+  delete[] retired.version_->page_.data_;
+  delete retired.version_;
+}
+
 auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard { return {this, NewPage(page_id)}; }
 
 }  // namespace CrazyDave
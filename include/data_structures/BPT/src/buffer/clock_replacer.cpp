@@ -0,0 +1,94 @@
+#include "buffer/clock_replacer.h"
+
+namespace CrazyDave {
+
+ClockReplacer::ClockReplacer(size_t num_frames)
+    : num_frames_(num_frames),
+      tracked_(new bool[num_frames]{}),
+      evictable_(new bool[num_frames]{}),
+      referenced_(new bool[num_frames]{}) {}
+
+ClockReplacer::~ClockReplacer() {
+  delete[] tracked_;
+  delete[] evictable_;
+  delete[] referenced_;
+}
+
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // two sweeps are enough: the first one clears every reference bit it passes
+  while (true) {
+    auto fid = static_cast<frame_id_t>(hand_);
+    hand_ = (hand_ + 1) % num_frames_;
+    if (!tracked_[fid] || !evictable_[fid]) {
+      continue;
+    }
+    if (referenced_[fid]) {
+      referenced_[fid] = false;
+      continue;
+    }
+    tracked_[fid] = false;
+    evictable_[fid] = false;
+    --curr_size_;
+    *frame_id = fid;
+    return true;
+  }
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, page_id_t /*page_id*/, AccessType access_type) {
+  if (access_type == AccessType::Scan) {
+    if (!tracked_[frame_id]) {
+      RecordPrefetch(frame_id);
+    }
+    return;
+  }
+  tracked_[frame_id] = true;
+  referenced_[frame_id] = true;
+}
+
+void ClockReplacer::RecordPrefetch(frame_id_t frame_id) {
+  tracked_[frame_id] = true;
+  referenced_[frame_id] = false;
+}
+
+auto ClockReplacer::GetVictims(frame_id_t *frames, size_t n) -> size_t {
+  // Evict() takes the unreferenced frames in hand order, then the referenced ones once their bits are cleared
+  size_t cnt = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < num_frames_ && cnt < n; ++i) {
+      auto fid = static_cast<frame_id_t>((hand_ + i) % num_frames_);
+      if (tracked_[fid] && evictable_[fid] && referenced_[fid] == (pass == 1)) {
+        frames[cnt++] = fid;
+      }
+    }
+  }
+  return cnt;
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (evictable_[frame_id] != set_evictable) {
+    if (set_evictable) {
+      ++curr_size_;
+    } else {
+      --curr_size_;
+    }
+  }
+  evictable_[frame_id] = set_evictable;
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (!tracked_[frame_id]) {
+    return;
+  }
+  if (evictable_[frame_id]) {
+    --curr_size_;
+  }
+  tracked_[frame_id] = false;
+  evictable_[frame_id] = false;
+}
+
+auto ClockReplacer::Size() -> size_t { return curr_size_; }
+
+}  // namespace CrazyDave
@@ -0,0 +1,84 @@
+#include "buffer/free_space_map.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace CrazyDave {
+
+auto FreeSpaceMap::BitmapPageId(size_t index) -> page_id_t {
+  return static_cast<page_id_t>(index * FSM_BITMAP_PAGE_BITS) + FSM_FIRST_BITMAP_PAGE_ID;
+}
+
+void FreeSpaceMap::Init() {
+  auto meta_guard = bpm_->FetchPageWrite(FSM_META_PAGE_ID);
+  std::memset(meta_guard.GetDataMut(), 0, MIN_PAGE_SIZE);
+  meta_guard.AsMut<FreeSpaceMetaPage>()->next_page_id_ = FSM_FIRST_BITMAP_PAGE_ID + 1;
+  auto bitmap_guard = bpm_->FetchPageWrite(FSM_FIRST_BITMAP_PAGE_ID);
+  std::memset(bitmap_guard.GetDataMut(), 0, MIN_PAGE_SIZE);
+}
+
+auto FreeSpaceMap::AllocatePage() -> page_id_t {
+  auto meta_guard = bpm_->FetchPageWrite(FSM_META_PAGE_ID);
+  auto *meta = meta_guard.AsMut<FreeSpaceMetaPage>();
+  if (meta->free_count_ > 0) {
+    for (size_t w = meta->hint_ / 64; w < FSM_SUMMARY_WORDS; ++w) {
+      if (meta->summary_[w] == 0) {
+        continue;
+      }
+      size_t index = w * 64 + std::countr_zero(meta->summary_[w]);
+      auto bitmap_guard = bpm_->FetchPageWrite(BitmapPageId(index));
+      auto *bits = bitmap_guard.AsMut<FreeSpaceBitmapPage>()->bits_;
+      auto *word = std::find_if(bits, bits + FSM_BITMAP_PAGE_BITS / 64, [](uint64_t x) { return x != 0; });
+      size_t bit = (word - bits) * 64 + std::countr_zero(*word);
+      *word &= *word - 1;
+      if (std::all_of(word, bits + FSM_BITMAP_PAGE_BITS / 64, [](uint64_t x) { return x == 0; })) {
+        meta->summary_[w] &= ~(uint64_t{1} << (index % 64));
+      }
+      meta->hint_ = index;
+      --meta->free_count_;
+      return static_cast<page_id_t>(index * FSM_BITMAP_PAGE_BITS + bit);
+    }
+  }
+  auto page_id = meta->next_page_id_++;
+  if (page_id == BitmapPageId(page_id / FSM_BITMAP_PAGE_BITS)) {
+    // the file grows into a new range, its bitmap page comes first
+    auto bitmap_guard = bpm_->FetchPageWrite(page_id);
+    std::memset(bitmap_guard.GetDataMut(), 0, MIN_PAGE_SIZE);
+    page_id = meta->next_page_id_++;
+  }
+  return page_id;
+}
+
+void FreeSpaceMap::DeallocatePage(page_id_t page_id) {
+  size_t index = page_id / FSM_BITMAP_PAGE_BITS;
+  if (page_id <= FSM_META_PAGE_ID || page_id == BitmapPageId(index)) {
+    return;
+  }
+  auto meta_guard = bpm_->FetchPageWrite(FSM_META_PAGE_ID);
+  auto *meta = meta_guard.AsMut<FreeSpaceMetaPage>();
+  if (page_id >= meta->next_page_id_) {
+    return;
+  }
+  auto bitmap_guard = bpm_->FetchPageWrite(BitmapPageId(index));
+  auto &word = bitmap_guard.AsMut<FreeSpaceBitmapPage>()->bits_[page_id % FSM_BITMAP_PAGE_BITS / 64];
+  auto mask = uint64_t{1} << (page_id % 64);
+  if ((word & mask) != 0) {
+    return;
+  }
+  word |= mask;
+  meta->summary_[index / 64] |= uint64_t{1} << (index % 64);
+  meta->hint_ = std::min(meta->hint_, static_cast<uint32_t>(index));
+  ++meta->free_count_;
+}
+
+auto FreeSpaceMap::GetPageCount() -> size_t {
+  return bpm_->FetchPageRead(FSM_META_PAGE_ID).As<FreeSpaceMetaPage>()->next_page_id_;
+}
+
+auto FreeSpaceMap::GetFreePageCount() -> size_t {
+  return bpm_->FetchPageRead(FSM_META_PAGE_ID).As<FreeSpaceMetaPage>()->free_count_;
+}
+
+}  // namespace CrazyDave
@@ -2,45 +2,56 @@
 
 namespace CrazyDave {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : node_store_(new LRUKNode[num_frames]), replacer_size_(num_frames), k_(k), victim_ranks_(new size_t[num_frames]) {}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   // latch_.lock();
   size_t max_diff = 0;
-  auto victim_it = node_store_.end();
-  for (auto it = node_store_.begin(); it != node_store_.end(); ++it) {
-    auto &node = it->second;
+  LRUKNode *victim = nullptr;
+  for (size_t i = 0; i < replacer_size_; ++i) {
+    auto &node = node_store_[i];
     if (!node.is_evictable_) {
       continue;
     }
     if (max_diff != inf_) {
       if (node.history_.size() < k_) {
         max_diff = inf_;
-        victim_it = it;
+        victim = &node;
       } else if (current_timestamp_ - node.history_.front() > max_diff) {
         max_diff = current_timestamp_ - node.history_.front();
-        victim_it = it;
+        victim = &node;
       }
     } else if (node.history_.size() < k_) {
-      if (node.history_.front() < victim_it->second.history_.front()) {
-        victim_it = it;
+      if (node.history_.front() < victim->history_.front()) {
+        victim = &node;
       }
     }
   }
-  if (victim_it == node_store_.end()) {
+  if (victim == nullptr) {
     // latch_.unlock();
     return false;
   }
-  *frame_id = victim_it->second.fid_;
+  *frame_id = victim->fid_;
   --curr_size_;
-  node_store_.erase(victim_it);
+  Reset(*victim);
   // latch_.unlock();
   return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, page_id_t /*page_id*/, AccessType access_type) {
   // latch_.lock();
   auto &node = node_store_[frame_id];
+  if (access_type == AccessType::Scan) {
+    if (node.history_.empty()) {
+      RecordPrefetch(frame_id);
+    }
+    return;
+  }
+  if (node.is_cold_) {
+    node.history_.clear();
+    node.is_cold_ = false;
+  }
   if (node.history_.empty()) {
     node.fid_ = frame_id;
     node.k_ = k_;
@@ -53,32 +64,76 @@ void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
   // latch_.unlock();
 }
 
+void LRUKReplacer::RecordPrefetch(frame_id_t frame_id) {
+  auto &node = node_store_[frame_id];
+  node.fid_ = frame_id;
+  node.k_ = k_;
+  node.history_.clear();
+  node.history_.push_back(0);
+  node.is_cold_ = true;
+}
+
+auto LRUKReplacer::GetVictims(frame_id_t *frames, size_t n) -> size_t {
+  // Evict() takes the frames with less than k accesses first, then the earliest front of the history. The rank
+  // puts both into one number, smaller ranks are evicted first.
+  if (n == 0) {
+    return 0;
+  }
+  size_t cnt = 0;
+  for (size_t fid = 0; fid < replacer_size_; ++fid) {
+    auto &node = node_store_[fid];
+    if (!node.is_evictable_) {
+      continue;
+    }
+    size_t rank = node.history_.front() | (node.history_.size() < k_ ? 0 : size_t{1} << 63);
+    if (cnt == n && rank >= victim_ranks_[cnt - 1]) {
+      continue;
+    }
+    size_t i = cnt < n ? cnt++ : cnt - 1;
+    for (; i > 0 && victim_ranks_[i - 1] > rank; --i) {
+      victim_ranks_[i] = victim_ranks_[i - 1];
+      frames[i] = frames[i - 1];
+    }
+    victim_ranks_[i] = rank;
+    frames[i] = node.fid_;
+  }
+  return cnt;
+}
+
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   // latch_.lock();
-  auto it = node_store_.find(frame_id);
-  if (it->second.is_evictable_ ^ set_evictable) {
+  auto &node = node_store_[frame_id];
+  if (node.is_evictable_ ^ set_evictable) {
     if (set_evictable) {
       ++curr_size_;
     } else {
       --curr_size_;
     }
   }
-  it->second.is_evictable_ = set_evictable;
+  node.is_evictable_ = set_evictable;
   // latch_.unlock();
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   // latch_.lock();
-  auto it = node_store_.find(frame_id);
-  if (it == node_store_.end()) {
+  auto &node = node_store_[frame_id];
+  if (node.history_.empty()) {
     // latch_.unlock();
     return;
   }
-  node_store_.erase(it);
-  --curr_size_;
+  if (node.is_evictable_) {
+    --curr_size_;
+  }
+  Reset(node);
   // latch_.unlock();
 }
 
+void LRUKReplacer::Reset(LRUKNode &node) {
+  node.history_.clear();
+  node.is_evictable_ = false;
+  node.is_cold_ = false;
+}
+
 auto LRUKReplacer::Size() -> size_t {
   // latch_.lock();
   auto res = curr_size_;
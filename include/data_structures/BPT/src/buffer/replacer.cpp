@@ -0,0 +1,22 @@
+#include "buffer/replacer.h"
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+
+namespace CrazyDave {
+
+auto MakeReplacer(ReplacerType replacer_type, size_t num_frames, size_t k) -> Replacer * {
+  switch (replacer_type) {
+    case ReplacerType::Clock:
+      return new ClockReplacer{num_frames};
+    case ReplacerType::TwoQueue:
+      return new TwoQueueReplacer{num_frames};
+    case ReplacerType::ARC:
+      return new ArcReplacer{num_frames};
+    default:
+      return new LRUKReplacer{num_frames, k};
+  }
+}
+
+}  // namespace CrazyDave
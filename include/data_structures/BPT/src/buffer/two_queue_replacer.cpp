@@ -0,0 +1,155 @@
+#include "buffer/two_queue_replacer.h"
+#include <algorithm>
+
+namespace CrazyDave {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : kin_(std::max(num_frames / 4, static_cast<size_t>(1))),
+      kout_(std::max(num_frames / 2, static_cast<size_t>(1))),
+      a1in_(num_frames),
+      am_(num_frames),
+      page_ids_(new page_id_t[num_frames]),
+      evictable_(new bool[num_frames]{}),
+      cold_(new bool[num_frames]{}) {}
+
+TwoQueueReplacer::~TwoQueueReplacer() {
+  delete[] page_ids_;
+  delete[] evictable_;
+  delete[] cold_;
+}
+
+auto TwoQueueReplacer::FirstEvictable(const FrameList &list) const -> frame_id_t {
+  for (auto fid = list.Front(); fid != -1; fid = list.Next(fid)) {
+    if (evictable_[fid] && !cold_[fid]) {
+      return fid;
+    }
+  }
+  return -1;
+}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  frame_id_t victim = -1;
+  for (auto fid = a1in_.Front(); fid != -1 && cold_[fid]; fid = a1in_.Next(fid)) {
+    if (evictable_[fid]) {
+      victim = fid;
+      break;
+    }
+  }
+  if (victim == -1 && a1in_.Size() > kin_) {
+    victim = FirstEvictable(a1in_);
+  }
+  if (victim == -1) {
+    victim = FirstEvictable(am_);
+  }
+  if (victim == -1) {
+    victim = FirstEvictable(a1in_);
+  }
+  if (victim == -1) {
+    return false;
+  }
+  if (a1in_.Contains(victim)) {
+    a1in_.Erase(victim);
+    if (!cold_[victim]) {
+      a1out_.insert({page_ids_[victim], true});
+      if (a1out_.size() > kout_) {
+        a1out_.erase(a1out_.begin());
+      }
+    }
+  } else {
+    am_.Erase(victim);
+  }
+  evictable_[victim] = false;
+  cold_[victim] = false;
+  --curr_size_;
+  *frame_id = victim;
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  bool tracked = a1in_.Contains(frame_id) || am_.Contains(frame_id);
+  if (access_type == AccessType::Scan) {
+    if (!tracked) {
+      RecordPrefetch(frame_id);
+    }
+    return;
+  }
+  if (tracked && !cold_[frame_id]) {
+    if (am_.Contains(frame_id)) {
+      am_.Erase(frame_id);
+      am_.PushBack(frame_id);
+    }
+    return;
+  }
+  // first real access to the page in this frame
+  if (tracked) {
+    a1in_.Erase(frame_id);
+  }
+  cold_[frame_id] = false;
+  page_ids_[frame_id] = page_id;
+  auto it = a1out_.find(page_id);
+  if (it != a1out_.end()) {
+    a1out_.erase(it);
+    am_.PushBack(frame_id);
+  } else {
+    a1in_.PushBack(frame_id);
+  }
+}
+
+void TwoQueueReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (a1in_.Contains(frame_id)) {
+    a1in_.Erase(frame_id);
+  } else if (am_.Contains(frame_id)) {
+    am_.Erase(frame_id);
+  }
+  a1in_.PushFront(frame_id);
+  cold_[frame_id] = true;
+}
+
+auto TwoQueueReplacer::GetVictims(frame_id_t *frames, size_t n) -> size_t {
+  size_t cnt = 0;
+  for (auto fid = a1in_.Front(); fid != -1 && cold_[fid] && cnt < n; fid = a1in_.Next(fid)) {
+    if (evictable_[fid]) {
+      frames[cnt++] = fid;
+    }
+  }
+  bool a1in_first = a1in_.Size() > kin_;
+  const FrameList *order[2] = {a1in_first ? &a1in_ : &am_, a1in_first ? &am_ : &a1in_};
+  for (auto *list : order) {
+    for (auto fid = list->Front(); fid != -1 && cnt < n; fid = list->Next(fid)) {
+      if (evictable_[fid] && !cold_[fid]) {
+        frames[cnt++] = fid;
+      }
+    }
+  }
+  return cnt;
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (evictable_[frame_id] != set_evictable) {
+    if (set_evictable) {
+      ++curr_size_;
+    } else {
+      --curr_size_;
+    }
+  }
+  evictable_[frame_id] = set_evictable;
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  if (a1in_.Contains(frame_id)) {
+    a1in_.Erase(frame_id);
+  } else if (am_.Contains(frame_id)) {
+    am_.Erase(frame_id);
+  } else {
+    return;
+  }
+  if (evictable_[frame_id]) {
+    --curr_size_;
+  }
+  evictable_[frame_id] = false;
+  cold_[frame_id] = false;
+}
+
+auto TwoQueueReplacer::Size() -> size_t { return curr_size_; }
+
+}  // namespace CrazyDave
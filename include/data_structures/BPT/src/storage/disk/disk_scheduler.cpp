@@ -0,0 +1,77 @@
+#include "storage/disk/disk_scheduler.h"
+
+namespace CrazyDave {
+
+DiskScheduler::DiskScheduler(MyDiskManager *disk_manager) : disk_manager_(disk_manager) {
+  background_thread_ = std::thread{[this] { StartWorkerThread(); }};
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  request_cv_.notify_one();
+  background_thread_.join();
+}
+
+auto DiskScheduler::Schedule(const DiskRequest &r) -> size_t {
+  size_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    requests_.push_back(r);
+    ticket = ++scheduled_;
+  }
+  request_cv_.notify_one();
+  return ticket;
+}
+
+void DiskScheduler::Wait(size_t ticket) {
+  std::unique_lock<std::mutex> lock(latch_);
+  done_cv_.wait(lock, [&] { return completed_ >= ticket; });
+}
+
+auto DiskScheduler::IsDone(size_t ticket) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  return completed_ >= ticket;
+}
+
+/*
+ * Pending requests are drained before the thread exits, so no ticket is left waiting.
+ */
+void DiskScheduler::StartWorkerThread() {
+  char *batch[MAX_WRITE_BATCH];
+  while (true) {
+    DiskRequest r;
+    int count = 1;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      request_cv_.wait(lock, [&] { return stop_ || !requests_.empty(); });
+      if (requests_.empty()) {
+        return;
+      }
+      r = requests_.front();
+      requests_.pop_front();
+      if (r.is_write_) {
+        batch[0] = r.data_;
+        while (count < MAX_WRITE_BATCH && !requests_.empty() && requests_.front().is_write_ &&
+               requests_.front().page_id_ == r.page_id_ + count) {
+          batch[count++] = requests_.front().data_;
+          requests_.pop_front();
+        }
+      }
+    }
+    if (r.is_write_) {
+      disk_manager_->WritePages(r.page_id_, batch, count);
+    } else {
+      disk_manager_->ReadPage(r.page_id_, r.data_);
+    }
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      completed_ += count;
+    }
+    done_cv_.notify_all();
+  }
+}
+
+}  // namespace CrazyDave
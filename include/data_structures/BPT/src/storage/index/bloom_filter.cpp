@@ -0,0 +1,71 @@
+#include "storage/index/bloom_filter.h"
+
+namespace CrazyDave {
+
+BloomFilter::~BloomFilter() { delete[] words_; }
+
+void BloomFilter::Reset(size_t capacity) {
+  delete[] words_;
+  capacity_ = capacity;
+  insert_count_ = 0;
+  num_blocks_ = (capacity * BITS_PER_KEY + BLOCK_WORDS * 64 - 1) / (BLOCK_WORDS * 64);
+  words_ = new uint64_t[num_blocks_ * BLOCK_WORDS]{};
+}
+
+void BloomFilter::Insert(uint64_t hash) {
+  uint64_t *block = words_ + BlockIndex(hash) * BLOCK_WORDS;
+  // every probe takes 9 bits of the hash: 3 for the word, 6 for the bit
+  uint64_t probe = hash;
+  for (int i = 0; i < NUM_PROBES; ++i, probe >>= 9) {
+    block[probe & 7] |= 1ULL << ((probe >> 3) & 63);
+  }
+  ++insert_count_;
+}
+
+auto BloomFilter::MayContain(uint64_t hash) const -> bool {
+  const uint64_t *block = words_ + BlockIndex(hash) * BLOCK_WORDS;
+  uint64_t probe = hash;
+  for (int i = 0; i < NUM_PROBES; ++i, probe >>= 9) {
+    if ((block[probe & 7] & (1ULL << ((probe >> 3) & 63))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BloomFilter::Save(MyFile &file) const {
+  file.SetWritePointer(0);
+  file.WriteObj(MAGIC);
+  file.WriteObj(static_cast<uint32_t>(0));
+  file.WriteObj(capacity_);
+  file.WriteObj(insert_count_);
+  file.Write(reinterpret_cast<const char *>(words_), static_cast<int>(num_blocks_ * BLOCK_WORDS * sizeof(uint64_t)));
+  file.Flush();
+}
+
+auto BloomFilter::Load(MyFile &file) -> bool {
+  uint32_t magic = 0;
+  uint32_t is_dirty = 1;
+  size_t capacity = 0;
+  size_t insert_count = 0;
+  file.SetReadPointer(0);
+  file.ReadObj(magic);
+  file.ReadObj(is_dirty);
+  file.ReadObj(capacity);
+  file.ReadObj(insert_count);
+  if (magic != MAGIC || is_dirty != 0 || capacity == 0) {
+    return false;
+  }
+  Reset(capacity);
+  file.Read(reinterpret_cast<char *>(words_), static_cast<int>(num_blocks_ * BLOCK_WORDS * sizeof(uint64_t)));
+  insert_count_ = insert_count;
+  return true;
+}
+
+void BloomFilter::MarkDirty(MyFile &file) {
+  file.SetWritePointer(sizeof(MAGIC));
+  file.WriteObj(static_cast<uint32_t>(1));
+  file.Flush();
+}
+
+}  // namespace CrazyDave
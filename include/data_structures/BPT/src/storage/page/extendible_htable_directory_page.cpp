@@ -0,0 +1,79 @@
+#include "storage/page/extendible_htable_directory_page.h"
+
+namespace CrazyDave {
+
+void ExtendibleHTableDirectoryPage::Init(uint32_t max_depth) {
+  max_depth_ = max_depth;
+  global_depth_ = 0;
+  for (uint32_t i = 0; i < MaxSize(); ++i) {
+    local_depths_[i] = 0;
+    bucket_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+auto ExtendibleHTableDirectoryPage::HashToBucketIndex(uint64_t hash) const -> uint32_t {
+  return static_cast<uint32_t>(hash) & GetGlobalDepthMask();
+}
+
+auto ExtendibleHTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const -> page_id_t {
+  return bucket_page_ids_[bucket_idx];
+}
+
+void ExtendibleHTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+auto ExtendibleHTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const -> uint32_t {
+  auto local_depth = local_depths_[bucket_idx];
+  if (local_depth == 0) {
+    return bucket_idx;
+  }
+  return bucket_idx ^ (1U << (local_depth - 1));
+}
+
+auto ExtendibleHTableDirectoryPage::GetGlobalDepthMask() const -> uint32_t { return (1U << global_depth_) - 1; }
+
+auto ExtendibleHTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) const -> uint32_t {
+  return (1U << local_depths_[bucket_idx]) - 1;
+}
+
+auto ExtendibleHTableDirectoryPage::GetGlobalDepth() const -> uint32_t { return global_depth_; }
+
+auto ExtendibleHTableDirectoryPage::GetMaxDepth() const -> uint32_t { return max_depth_; }
+
+void ExtendibleHTableDirectoryPage::IncrGlobalDepth() {
+  auto size = Size();
+  for (uint32_t i = 0; i < size; ++i) {
+    local_depths_[i + size] = local_depths_[i];
+    bucket_page_ids_[i + size] = bucket_page_ids_[i];
+  }
+  ++global_depth_;
+}
+
+void ExtendibleHTableDirectoryPage::DecrGlobalDepth() { --global_depth_; }
+
+auto ExtendibleHTableDirectoryPage::CanShrink() const -> bool {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < Size(); ++i) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto ExtendibleHTableDirectoryPage::Size() const -> uint32_t { return 1U << global_depth_; }
+
+auto ExtendibleHTableDirectoryPage::MaxSize() const -> uint32_t { return 1U << max_depth_; }
+
+auto ExtendibleHTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const -> uint32_t {
+  return local_depths_[bucket_idx];
+}
+
+void ExtendibleHTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
+  local_depths_[bucket_idx] = local_depth;
+}
+
+}  // namespace CrazyDave
@@ -0,0 +1,32 @@
+#include "storage/page/extendible_htable_header_page.h"
+
+namespace CrazyDave {
+
+void ExtendibleHTableHeaderPage::Init(uint32_t max_depth) {
+  max_depth_ = max_depth;
+  for (uint32_t i = 0; i < MaxSize(); ++i) {
+    directory_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+/*
+ * The directories use the low bits of the hash, so the header takes the high ones.
+ */
+auto ExtendibleHTableHeaderPage::HashToDirectoryIndex(uint64_t hash) const -> uint32_t {
+  if (max_depth_ == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(hash >> (64 - max_depth_));
+}
+
+auto ExtendibleHTableHeaderPage::GetDirectoryPageId(uint32_t directory_idx) const -> page_id_t {
+  return directory_page_ids_[directory_idx];
+}
+
+void ExtendibleHTableHeaderPage::SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+  directory_page_ids_[directory_idx] = directory_page_id;
+}
+
+auto ExtendibleHTableHeaderPage::MaxSize() const -> uint32_t { return 1U << max_depth_; }
+
+}  // namespace CrazyDave
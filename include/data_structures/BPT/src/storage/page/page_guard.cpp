@@ -14,7 +14,9 @@ void BasicPageGuard::Drop() {
   if (page_ == nullptr) {
     return;
   }
-  bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  if (bpm_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  }
   bpm_ = nullptr;
   page_ = nullptr;
   is_dirty_ = false;
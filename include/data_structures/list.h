@@ -1,6 +1,7 @@
 #ifndef BPT_PRO_LIST_H
 #define BPT_PRO_LIST_H
 #include <cstddef>
+#include <utility>
 namespace CrazyDave {
 template <typename T>
 class list {
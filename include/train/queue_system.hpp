@@ -1,6 +1,7 @@
 #ifndef TICKETSYSTEM_QUEUE_SYSTEM_HPP
 #define TICKETSYSTEM_QUEUE_SYSTEM_HPP
 
+#include "common/snapshot.hpp"
 #include "common/utils.hpp"
 #include "data_structures/list.h"
 namespace CrazyDave {
@@ -42,6 +43,9 @@ class QueueSystem {
   auto end() -> list<Query>::iterator;
   void erase(const list<Query>::iterator &it);
   void reset();
+  auto size() const -> size_t;
+  void save(SnapshotWriter &writer);
+  auto load(SnapshotReader &reader) -> bool;
 };
 }  // namespace CrazyDave
 #endif  // TICKETSYSTEM_QUEUE_SYSTEM_HPP
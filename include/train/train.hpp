@@ -1,14 +1,20 @@
 #ifndef TICKET_SYSTEM_TRAIN_HPP
 #define TICKET_SYSTEM_TRAIN_HPP
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include "common/management_system.hpp"
+#include "common/snapshot.hpp"
+#include "common/stats.hpp"
 #include "common/utils.hpp"
 
 #include "data_structures/linked_hashmap.h"
 #include "data_structures/vector.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/extendible_hash_table.h"
 #include "train/queue_system.hpp"
 
 namespace CrazyDave {
@@ -18,9 +24,13 @@ enum class Status { SUCCESS, PENDING, REFUNDED };
 class TrainSystem;
 class QueueSystem;
 class TrainIO;
+class SeatMatrix;
+// 一行余票最多 99 个四字节计数，一页放得下 31 天，售票期不超过三个月，矩阵最多三页
+static constexpr int SEAT_PAGE_NUM = 3;
 class TrainMeta {
   friend TrainSystem;
   friend TrainIO;
+  friend SeatMatrix;
   String<20> train_id_{};
   short station_num_{};
   int seat_num_{};
@@ -28,6 +38,7 @@ class TrainMeta {
   char type_{};
   bool is_released_{};
   int index_{};  // the position in storage file
+  page_id_t seat_pages_[SEAT_PAGE_NUM]{};  // 发布后余票矩阵的页，见 SeatMatrix
  public:
   TrainMeta() = default;
   TrainMeta(const std::string &train_id, int station_num, int seat_num, DateRange sale_date_range, char type)
@@ -75,11 +86,120 @@ class TrainArray {
 
   //  auto operator<(const Train &rhs) const -> bool { return train_id_ < rhs.train_id_; }
 };
-struct DateInfo {
-  short date_index_{};
-  int seat_num_[100]{};  // [station][date] date 是从始发站出发的日期 index
-  auto operator!=(const DateInfo &rhs) const -> bool { return date_index_ != rhs.date_index_; }
-  auto operator<(const DateInfo &rhs) const -> bool { return date_index_ < rhs.date_index_; }
+/*
+ * 每个车次全部日期的余票矩阵 [date][segment]，date 是从始发站出发的日期 index，存在 sm 文件专门的页里，
+ * 页号记在 TrainMeta::seat_pages_。每天一行，存 station_num_ - 1 个区间的余票，座位数放得进 uint16_t 的车次
+ * 每个计数两字节，否则四字节。一行不跨页，某天某段区间的余票取一页之后就是指针运算；一行的计数连续存放，
+ * 区间最小值是数组上的 min，编译器会向量化。
+ */
+class SeatMatrix {
+ public:
+  // 快照里的一页
+  struct SeatPage {
+    char data_[BUSTUB_PAGE_SIZE];
+  };
+
+  SeatMatrix() { bpm_ = new BufferPoolManager{NAME, POOL_SIZE, 5, ReplacerType::TwoQueue}; }
+  ~SeatMatrix() { delete bpm_; }
+
+  // 给刚发布的车次分配矩阵，每个区间都是 seat_num_ 张，页号写进 meta.seat_pages_
+  void allocate(TrainMeta &meta) {
+    auto layout = get_layout(meta);
+    int dates = meta.sale_date_range_.second - meta.sale_date_range_.first + 1;
+    std::fill_n(meta.seat_pages_, SEAT_PAGE_NUM, INVALID_PAGE_ID);
+    for (int k = 0; k * layout.rows_per_page_ < dates; ++k) {
+      auto guard = bpm_->NewPageGuarded(&meta.seat_pages_[k]);
+      int count = std::min(layout.rows_per_page_, dates - k * layout.rows_per_page_) * layout.segments_;
+      if (layout.width_ == 2) {
+        std::fill_n(reinterpret_cast<uint16_t *>(guard.GetDataMut()), count, static_cast<uint16_t>(meta.seat_num_));
+      } else {
+        std::fill_n(reinterpret_cast<uint32_t *>(guard.GetDataMut()), count, static_cast<uint32_t>(meta.seat_num_));
+      }
+    }
+  }
+  // 第 date_index 天区间 [from, to) 的最少余票
+  auto min(const TrainMeta &meta, int date_index, int from, int to) -> int {
+    auto layout = get_layout(meta);
+    auto guard = bpm_->FetchPageRead(meta.seat_pages_[date_index / layout.rows_per_page_]);
+    const char *row = guard.GetData() + row_offset(layout, date_index);
+    return layout.width_ == 2 ? range_min(reinterpret_cast<const uint16_t *>(row) + from, to - from)
+                              : range_min(reinterpret_cast<const uint32_t *>(row) + from, to - from);
+  }
+  // 第 date_index 天每个区间的余票
+  void read(const TrainMeta &meta, int date_index, int *seats) {
+    auto layout = get_layout(meta);
+    auto guard = bpm_->FetchPageRead(meta.seat_pages_[date_index / layout.rows_per_page_]);
+    const char *row = guard.GetData() + row_offset(layout, date_index);
+    if (layout.width_ == 2) {
+      std::copy_n(reinterpret_cast<const uint16_t *>(row), layout.segments_, seats);
+    } else {
+      std::copy_n(reinterpret_cast<const uint32_t *>(row), layout.segments_, seats);
+    }
+  }
+  // 第 date_index 天区间 [from, to) 的余票都加上 delta
+  void add(const TrainMeta &meta, int date_index, int from, int to, int delta) {
+    auto layout = get_layout(meta);
+    auto guard = bpm_->FetchPageWrite(meta.seat_pages_[date_index / layout.rows_per_page_]);
+    char *row = guard.GetDataMut() + row_offset(layout, date_index);
+    if (layout.width_ == 2) {
+      auto *counters = reinterpret_cast<uint16_t *>(row);
+      for (int i = from; i < to; ++i) {
+        counters[i] = static_cast<uint16_t>(counters[i] + delta);
+      }
+    } else {
+      auto *counters = reinterpret_cast<uint32_t *>(row);
+      for (int i = from; i < to; ++i) {
+        counters[i] = static_cast<uint32_t>(static_cast<int>(counters[i]) + delta);
+      }
+    }
+  }
+
+  // 车次的第 k 页
+  void read_page(const TrainMeta &meta, int k, SeatPage &page) {
+    auto guard = bpm_->FetchPageRead(meta.seat_pages_[k], AccessType::Scan);
+    std::memcpy(page.data_, guard.GetData(), BUSTUB_PAGE_SIZE);
+  }
+  // 新分配一页存 page，返回页号
+  auto write_page(const SeatPage &page) -> page_id_t {
+    page_id_t page_id;
+    auto guard = bpm_->NewPageGuarded(&page_id);
+    std::memcpy(guard.GetDataMut(), page.data_, BUSTUB_PAGE_SIZE);
+    return page_id;
+  }
+  // 丢掉全部矩阵，从空文件重新开始
+  void clear() {
+    delete bpm_;
+    std::remove((std::string{NAME} + "_dt").c_str());
+    bpm_ = new BufferPoolManager{NAME, POOL_SIZE, 5, ReplacerType::TwoQueue};
+  }
+  void print_stats(std::ostream &os) { print_pool_stats(os, NAME, bpm_, bpm_->GetStats()); }
+
+ private:
+  static constexpr const char *NAME = "sm";
+  static constexpr size_t POOL_SIZE = 100;
+  struct Layout {
+    int segments_;
+    int width_;
+    int rows_per_page_;
+  };
+  static auto get_layout(const TrainMeta &meta) -> Layout {
+    int segments = meta.station_num_ - 1;
+    int width = meta.seat_num_ <= UINT16_MAX ? 2 : 4;
+    return {segments, width, BUSTUB_PAGE_SIZE / (segments * width)};
+  }
+  static auto row_offset(const Layout &layout, int date_index) -> int {
+    return date_index % layout.rows_per_page_ * layout.segments_ * layout.width_;
+  }
+  template <class T>
+  static auto range_min(const T *counters, int n) -> int {
+    T res = counters[0];
+    for (int i = 1; i < n; ++i) {
+      res = counters[i] < res ? counters[i] : res;
+    }
+    return static_cast<int>(res);
+  }
+
+  BufferPoolManager *bpm_;
 };
 
 class TrainIO {
@@ -91,51 +211,77 @@ class TrainIO {
 #else
   BPT<size_t, size_t> index_storage_{"idx_st", 0, 15, 5};
   File array_storage_{"arr_st"};
-  File garbage_storage_{"arr_gb"};
+  File free_storage_{"arr_fs"};  // FreeIndexHeader，之后每个 bit 表示一个 index 是否空闲
 #endif
   static const size_t SIZE_OF_ARRAY = sizeof(TrainArray);
-  size_t max_index_{0};
-  list<size_t> queue_{};
+  struct FreeIndexHeader {
+    size_t max_index_{};
+    size_t free_count_{};
+    size_t hint_{};  // no word before this one has a free index
+  };
+  FreeIndexHeader header_{};
+
+  auto word_pos(size_t word) -> size_t { return sizeof(FreeIndexHeader) + word * sizeof(uint64_t); }
+  auto read_word(size_t word) -> uint64_t {
+    uint64_t bits;
+    free_storage_.seekg(word_pos(word));
+    free_storage_.read(bits);
+    return bits;
+  }
+  void write_word(size_t word, uint64_t bits) {
+    free_storage_.seekp(word_pos(word));
+    free_storage_.write(bits);
+  }
+  void write_header() {
+    free_storage_.seekp(0);
+    free_storage_.write(header_);
+  }
 
  public:
   TrainIO() {
     array_storage_.open();
-    garbage_storage_.open();
-    if (!garbage_storage_.get_is_new()) {
-      garbage_storage_.seekg(0);
-      size_t size;
-      garbage_storage_.read(size);
-      garbage_storage_.read(max_index_);
-      for (size_t i = 0; i < size; ++i) {
-        size_t index;
-        garbage_storage_.read(index);
-        queue_.push_back(index);
-      }
+    free_storage_.open();
+    if (free_storage_.get_is_new()) {
+      write_header();
+      write_word(0, 0);
+    } else {
+      free_storage_.seekg(0);
+      free_storage_.read(header_);
     }
   }
   ~TrainIO() {
-    garbage_storage_.seekp(0);
-    size_t size = queue_.size();
-    garbage_storage_.write(size);
-    garbage_storage_.write(max_index_);
-    while(!queue_.empty()) {
-      size_t index = queue_.back();
-      queue_.pop_back();
-      garbage_storage_.write(index);
-    }
     array_storage_.close();
-    garbage_storage_.close();
+    free_storage_.close();
   }
 
+  // 空闲的 index 记在 arr_fs 的位图里，每次分配和回收只读写一个字和文件头
   auto allocate_index() -> size_t {
-    if (!queue_.empty()) {
-      size_t index = queue_.back();
-      queue_.pop_back();
+    for (size_t w = header_.hint_; header_.free_count_ > 0; ++w) {
+      auto bits = read_word(w);
+      if (bits == 0) {
+        continue;
+      }
+      size_t index = w * 64 + std::countr_zero(bits);
+      write_word(w, bits & (bits - 1));
+      --header_.free_count_;
+      header_.hint_ = w;
+      write_header();
       return index;
     }
-    return max_index_++;
+    size_t index = header_.max_index_++;
+    if (header_.max_index_ % 64 == 0) {
+      write_word(header_.max_index_ / 64, 0);
+    }
+    write_header();
+    return index;
+  }
+  void deallocate_index(size_t index) {
+    auto bits = read_word(index / 64);
+    write_word(index / 64, bits | uint64_t{1} << (index % 64));
+    ++header_.free_count_;
+    header_.hint_ = std::min(header_.hint_, index / 64);
+    write_header();
   }
-  void deallocate_index(size_t index) { queue_.push_back(index); }
   void insert_array(size_t train_hs, TrainMeta &meta, TrainArray &array) {
     size_t index = allocate_index();
     index_storage_.insert(train_hs, index);
@@ -153,6 +299,47 @@ class TrainIO {
     array_storage_.seekg(index * SIZE_OF_ARRAY);
     array_storage_.read(array);
   }
+
+  // 数组按车次哈希的顺序写出，train_hs 依次记下这些哈希
+  void save(SnapshotWriter &writer, vector<size_t> &train_hs) {
+    writer.begin_section<size_t, TrainArray>(SnapshotSection::TRAIN_ARRAYS);
+    TrainArray array;
+    index_storage_.for_all([&](size_t hs, size_t index) {
+      read_array(index, array);
+      writer.append(hs, array);
+      train_hs.push_back(hs);
+    });
+    writer.end_section();
+  }
+  // 载入的数组依次放在 0, 1, 2, ...，不再有空闲的 index
+  auto load(SnapshotReader &reader) -> bool {
+    if (!reader.begin_section<size_t, TrainArray>(SnapshotSection::TRAIN_ARRAYS)) {
+      return false;
+    }
+    vector<pair<size_t, size_t>> indexes;
+    size_t hs;
+    TrainArray array;
+    array_storage_.clear();
+    array_storage_.seekp(0);
+    while (reader.read(hs, array)) {
+      array_storage_.write(array);
+      indexes.push_back({hs, indexes.size()});
+    }
+    index_storage_.clear();
+    index_storage_.bulk_load(indexes);
+    header_ = {indexes.size(), 0, 0};
+    free_storage_.clear();
+    write_header();
+    for (size_t w = 0; w <= header_.max_index_ / 64; ++w) {
+      write_word(w, 0);
+    }
+    return true;
+  }
+
+  void print_stats(std::ostream &os) {
+    print_index_stats(os, index_storage_);
+    os << "train_io arrays " << header_.max_index_ << " free_indexes " << header_.free_count_ << "\n";
+  }
 };
 class TrainSystem {
   struct Record {
@@ -211,6 +398,7 @@ class TrainSystem {
     }
     auto operator<(const Trade &rhs) const -> bool { return time_stamp_ > rhs.time_stamp_; }
   };
+  static_assert(std::is_trivially_copyable_v<Record> && std::is_trivially_copyable_v<Trade>);
 
   struct TicketResult {
     String<20> train_id{};
@@ -232,27 +420,29 @@ class TrainSystem {
 #ifdef DEBUG_FILE_IN_TMP
   MyBPlusTree<size_t, Seat> seat_storage_{"tmp/se1", "tmp/se2", "tmp/se3", "tmp/se4"};
   MyBPlusTree<size_t, Train> train_storage_{"tmp/tr1", "tmp/tr2", "tmp/tr3", "tmp/tr4"};
-  BPT<size_t, Trade> trade_storage_{"tmp/trd", 0, 300, 30};
-  BPT<size_t, Record> station_storage_{"tmp/st", 0, 300, 30};
+  BPT<size_t, Trade, BUSTUB_PAGE_SIZE, LeafFormat::RunLength> trade_storage_{"tmp/trd", 0, 300, 30};
+  BPT<size_t, Record, BUSTUB_PAGE_SIZE, LeafFormat::RunLength> station_storage_{"tmp/st", 0, 300, 30};
 #else
 
-  BPT<size_t, TrainMeta> meta_storage_{"mta", 0, 60, 5};
-  BPT<size_t, Trade> trade_storage_{"trd", 0, 60, 5};
-  BPT<size_t, Record> station_storage_{"st", 0, 60, 5};
-  BPT<pair<size_t, int>, DateInfo> date_info_storage_{"se", 0, 100, 5};
+  EHT<size_t, TrainMeta> meta_storage_{"mta", 0, 60, 5};
+  // 同一用户的订单、经过同一车站的车次首键相同，叶子里每段首键只存一次
+  BPT<size_t, Trade, BUSTUB_PAGE_SIZE, LeafFormat::RunLength> trade_storage_{"trd", 0, 60, 5};
+  BPT<size_t, Record, BUSTUB_PAGE_SIZE, LeafFormat::RunLength> station_storage_{"st", 0, 60, 5};
 
 #endif
   QueueSystem q_sys_;
   ManagementSystem *m_sys_{};
   TrainIO t_io_{};
+  // Seat pages of candidate trains are read once per query; 2Q had the best hit rate in replacer_replay
+  SeatMatrix seats_{};
 
   /*
    * 检查候补队列，将能够补票的所有订单补票
    */
-  void check_queue(size_t train_hs, int station_index_1, int station_index_2, int date_index);
+  void check_queue(size_t train_hs, const TrainMeta &meta, int station_index_1, int station_index_2, int date_index);
 
  public:
-  TrainSystem() = default;
+  TrainSystem();
   explicit TrainSystem(ManagementSystem *m_sys);
   void load_management_system(ManagementSystem *m_sys);
   auto add_train(const std::string &train_id, int seat_num, const vector<std::string> &stations,
@@ -273,6 +463,13 @@ class TrainSystem {
   auto query_order(const std::string &user_name) -> bool;
   auto refund_ticket(const std::string &user_name, int n) -> bool;
   void clear();
+  void print_stats(std::ostream &os);
+  auto compact(double fill_factor) -> bool;
+  void save(SnapshotWriter &writer);
+  /*
+   * 用快照替换全部车次、订单和候补队列
+   */
+  auto load(SnapshotReader &reader) -> bool;
 
 };
 
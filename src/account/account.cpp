@@ -18,9 +18,8 @@ auto AccountSystem::add_user(const std::optional<std::string> &cur_user_name, co
     if (it == login_list_.end()) {
       return false;
     }
-    vector<Account> cur_user_vec;
-    account_storage_.find(cur_hs, cur_user_vec);
-    auto &cur_user = cur_user_vec[0];
+    Account cur_user;
+    account_storage_.find_first(cur_hs, cur_user);
     if (cur_user.privilege_ <= privilege) {
       return false;
     }
@@ -39,12 +38,11 @@ auto AccountSystem::login(const std::string &user_name, const std::string &passw
   if (it != login_list_.end()) {
     return false;
   }
-  vector<Account> user_vec;
-  account_storage_.find(user_hs, user_vec);
-  if (user_vec.empty() || user_vec[0].password_ != password) {
+  Account user;
+  if (!account_storage_.find_first(user_hs, user) || user.password_ != password) {
     return false;
   }
-  login_list_.insert({user_hs, user_vec[0].privilege_});
+  login_list_.insert({user_hs, user.privilege_});
   return true;
 }
 auto AccountSystem::logout(const std::string &user_name) -> bool {
@@ -63,12 +61,10 @@ auto AccountSystem::query_profile(const std::string &cur_user_name, const std::s
     return false;
   }
   auto user_hs = HashBytes(user_name.c_str());
-  vector<Account> user_vec;
-  account_storage_.find(user_hs, user_vec);
-  if (user_vec.empty()) {
+  Account user;
+  if (!account_storage_.find_first(user_hs, user)) {
     return false;
   }
-  auto &user = user_vec[0];
   if (cur_hs != user_hs) {
     if (it->second <= user.privilege_) {
       return false;
@@ -87,12 +83,10 @@ auto AccountSystem::modify_profile(const std::string &cur_user_name, const std::
     return false;
   }
   auto user_hs = HashBytes(user_name.c_str());
-  vector<Account> user_vec;
-  account_storage_.find(user_hs, user_vec);
-  if (user_vec.empty()) {
+  Account user;
+  if (!account_storage_.find_first(user_hs, user)) {
     return false;
   }
-  auto &user = user_vec[0];
 
   if (cur_hs != user_hs && it->second <= user.privilege_) {
     return false;
@@ -142,5 +136,33 @@ AccountSystem::~AccountSystem() {
   header_.write(is_new_);
   header_.close();
 }
+void AccountSystem::save(SnapshotWriter &writer) {
+  writer.begin_section<bool>(SnapshotSection::ACCOUNT_HEADER);
+  writer.append(is_new_);
+  writer.end_section();
+  save_index<size_t, Account>(writer, SnapshotSection::ACCOUNTS, account_storage_);
+}
+auto AccountSystem::load(SnapshotReader &reader) -> bool {
+  if (!reader.begin_section<bool>(SnapshotSection::ACCOUNT_HEADER)) {
+    return false;
+  }
+  while (reader.read(is_new_)) {
+  }
+  if (!reader.begin_section<size_t, Account>(SnapshotSection::ACCOUNTS)) {
+    return false;
+  }
+  account_storage_.clear();
+  login_list_.clear();
+  size_t user_hs;
+  Account user;
+  while (reader.read(user_hs, user)) {
+    account_storage_.insert(user_hs, user);
+  }
+  return true;
+}
 void AccountSystem::load_management_system(ManagementSystem *m_sys) { m_sys_ = m_sys; }
+void AccountSystem::print_stats(std::ostream &os) {
+  print_index_stats(os, account_storage_);
+  os << "login_list size " << login_list_.size() << "\n";
+}
 }  // namespace CrazyDave
\ No newline at end of file
@@ -1,5 +1,28 @@
 #include "common/management_system.hpp"
+#include <chrono>
 namespace CrazyDave {
+static const char *const COMMAND_NAMES[] = {
+    "add_user",    "login",        "logout",       "query_profile", "modify_profile", "add_train",
+    "delete_train", "release_train", "query_train", "query_ticket",  "query_transfer", "buy_ticket",
+    "query_order", "refund_ticket", "clean",        "exit",          "stats",          "compact",
+    "snapshot"};
+static constexpr int COMMAND_NUM = sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+struct CommandCounter {
+  size_t count_{};
+  size_t failed_{};
+  size_t time_ns_{};
+};
+// the last slot counts unknown commands
+thread_local CommandCounter command_counters[COMMAND_NUM + 1];
+
+static auto get_command_id(const std::string &command) -> int {
+  for (int i = 0; i < COMMAND_NUM; ++i) {
+    if (command == COMMAND_NAMES[i]) {
+      return i;
+    }
+  }
+  return COMMAND_NUM;
+}
 auto ManagementSystem::check_is_login(const std::string &username) -> bool {
   return account_sys_->check_is_login(username);
 }
@@ -19,7 +42,7 @@ auto ManagementSystem::execute_line(const std::string &line) -> bool {
   enum OutputType { SIMPLE, F_SIMPLE, NORMAL } output_type = SIMPLE;
   bool success = false;
   auto &command = tokens[1];
-  bool flag=tokens[0]=="[207]";
+  auto start_time = std::chrono::steady_clock::now();
   if (command == "add_user") {
     std::optional<std::string> cur_user_name;
     std::optional<int> privilege;
@@ -271,6 +294,47 @@ auto ManagementSystem::execute_line(const std::string &line) -> bool {
   } else if (command == "exit") {
     std::cout << "bye\n";
     return false;
+  } else if (command == "stats") {
+    std::string file_name;
+    int interval = 1000;
+    for (int i = 2; i < (int)tokens.size(); i += 2) {
+      auto &key = tokens[i];
+      auto &value = tokens[i + 1];
+      if (key[1] == 'f') {
+        file_name = value;
+      } else if (key[1] == 'n') {
+        interval = std::stoi(value);
+      }
+    }
+    if (file_name.empty()) {
+      output_type = NORMAL;
+      print_stats(std::cout);
+    } else {
+      output_type = SIMPLE;
+      if (stats_file_.is_open()) {
+        stats_file_.close();
+      }
+      stats_file_.open(file_name, std::ios::app);
+      success = stats_file_.is_open();
+      stats_interval_ = success ? interval : 0;
+      commands_since_dump_ = 0;
+    }
+  } else if (command == "compact") {
+    int fill_percent = 90;
+    for (int i = 2; i < (int)tokens.size(); i += 2) {
+      if (tokens[i][1] == 'f') {
+        fill_percent = std::stoi(tokens[i + 1]);
+      }
+    }
+    output_type = SIMPLE;
+    success = fill_percent > 0 && fill_percent <= 100 && train_sys_->compact(fill_percent / 100.0);
+  } else if (command == "snapshot") {
+    output_type = SIMPLE;
+    if (tokens.size() >= 4 && tokens[2] == "save") {
+      success = save_snapshot(tokens[3]);
+    } else if (tokens.size() >= 4 && tokens[2] == "load") {
+      success = load_snapshot(tokens[3]);
+    }
   }
 #ifdef DEBUG_FILE_IN_TMP
   else if (command == "print_queue") {
@@ -286,8 +350,47 @@ auto ManagementSystem::execute_line(const std::string &line) -> bool {
       std::cout << "-1\n";
     }
   }
+
+  auto &counter = command_counters[get_command_id(command)];
+  ++counter.count_;
+  if (output_type != NORMAL && !success) {
+    ++counter.failed_;
+  }
+  counter.time_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time)
+                          .count();
+  if (stats_interval_ > 0 && ++commands_since_dump_ >= stats_interval_) {
+    commands_since_dump_ = 0;
+    stats_file_ << tokens[0] << "\n";
+    print_stats(stats_file_);
+    stats_file_.flush();
+  }
   return true;
 }
+void ManagementSystem::print_stats(std::ostream &os) {
+  for (int i = 0; i <= COMMAND_NUM; ++i) {
+    auto &counter = command_counters[i];
+    if (counter.count_ == 0) {
+      continue;
+    }
+    os << "command " << (i < COMMAND_NUM ? COMMAND_NAMES[i] : "unknown") << " count " << counter.count_ << " failed "
+       << counter.failed_ << " time_ms " << counter.time_ns_ / 1000000.0 << "\n";
+  }
+  account_sys_->print_stats(os);
+  train_sys_->print_stats(os);
+}
+auto ManagementSystem::save_snapshot(const std::string &path) -> bool {
+  SnapshotWriter writer{path};
+  if (!writer.is_open()) {
+    return false;
+  }
+  account_sys_->save(writer);
+  train_sys_->save(writer);
+  return writer.close();
+}
+auto ManagementSystem::load_snapshot(const std::string &path) -> bool {
+  SnapshotReader reader{path};
+  return reader.is_valid() && account_sys_->load(reader) && train_sys_->load(reader);
+}
 ManagementSystem::ManagementSystem(AccountSystem *account_sys, TrainSystem *train_sys)
     : account_sys_{account_sys}, train_sys_{train_sys} {}
 ManagementSystem::~ManagementSystem() = default;
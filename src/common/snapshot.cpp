@@ -0,0 +1,102 @@
+#include "common/snapshot.hpp"
+#include <algorithm>
+#include <cstdio>
+namespace CrazyDave {
+static constexpr char SNAPSHOT_MAGIC[8] = {'C', 'D', 'T', 'S', 'S', 'N', 'A', 'P'};
+static constexpr uint32_t SNAPSHOT_VERSION = 3;
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+static auto fnv1a(uint64_t hash, const char *bytes, size_t size) -> uint64_t {
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(bytes[i])) * FNV_PRIME;
+  }
+  return hash;
+}
+
+SnapshotWriter::SnapshotWriter(const std::string &path)
+    : path_(path), out_(path + ".tmp", std::ios::binary | std::ios::trunc), checksum_(FNV_OFFSET_BASIS) {
+  buffer_ = new char[CHUNK_SIZE];
+  write_bytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  write_bytes(&SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+}
+SnapshotWriter::~SnapshotWriter() {
+  delete[] buffer_;
+  if (out_.is_open()) {
+    // 没有 close() 的快照不完整，不留下来
+    out_.close();
+    std::remove((path_ + ".tmp").c_str());
+  }
+}
+void SnapshotWriter::write_bytes(const void *src, size_t size) {
+  checksum_ = fnv1a(checksum_, static_cast<const char *>(src), size);
+  out_.write(static_cast<const char *>(src), static_cast<long>(size));
+}
+void SnapshotWriter::flush_chunk() {
+  if (chunk_count_ == 0) {
+    return;
+  }
+  write_bytes(&chunk_count_, sizeof(chunk_count_));
+  write_bytes(buffer_, buffer_size_);
+  chunk_count_ = 0;
+  buffer_size_ = 0;
+}
+void SnapshotWriter::end_section() {
+  flush_chunk();
+  uint32_t end = 0;
+  write_bytes(&end, sizeof(end));
+}
+auto SnapshotWriter::close() -> bool {
+  auto end = SnapshotSection::END;
+  write_bytes(&end, sizeof(end));
+  auto checksum = checksum_;
+  out_.write(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+  out_.close();
+  bool success = !out_.fail() && std::rename((path_ + ".tmp").c_str(), path_.c_str()) == 0;
+  if (!success) {
+    std::remove((path_ + ".tmp").c_str());
+  }
+  return success;
+}
+
+SnapshotReader::SnapshotReader(const std::string &path) : in_(path, std::ios::binary) {
+  valid_ = in_.is_open() && verify();
+  in_.clear();
+  in_.seekg(sizeof(SNAPSHOT_MAGIC) + sizeof(SNAPSHOT_VERSION));
+}
+auto SnapshotReader::verify() -> bool {
+  uint64_t checksum = FNV_OFFSET_BASIS;
+  auto *buffer = new char[1 << 16];
+  auto read_hashed = [&](void *dst, size_t size) {
+    read_bytes(dst, size);
+    checksum = fnv1a(checksum, static_cast<const char *>(dst), size);
+    return in_.good();
+  };
+  char magic[sizeof(SNAPSHOT_MAGIC)];
+  uint32_t version{};
+  bool valid = read_hashed(magic, sizeof(magic)) && std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0 &&
+               read_hashed(&version, sizeof(version)) && version == SNAPSHOT_VERSION;
+  // 顺着分块走一遍，结构不对的文件也读不到 checksum 那里
+  auto tag = SnapshotSection::END;
+  while (valid && read_hashed(&tag, sizeof(tag)) && tag != SnapshotSection::END) {
+    uint32_t entry_size{};
+    uint32_t count{};
+    valid = read_hashed(&entry_size, sizeof(entry_size)) && entry_size > 0 && entry_size <= (1 << 16);
+    while (valid && read_hashed(&count, sizeof(count)) && count > 0) {
+      for (size_t left = static_cast<size_t>(count) * entry_size; valid && left > 0;) {
+        size_t size = std::min(left, static_cast<size_t>(1 << 16));
+        valid = read_hashed(buffer, size);
+        left -= size;
+      }
+    }
+    valid = valid && in_.good();
+  }
+  delete[] buffer;
+  if (!valid || !in_.good()) {
+    return false;
+  }
+  uint64_t stored{};
+  read_bytes(&stored, sizeof(stored));
+  return in_.good() && stored == checksum && in_.peek() == std::ifstream::traits_type::eof();
+}
+}  // namespace CrazyDave
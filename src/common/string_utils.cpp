@@ -1,4 +1,5 @@
 #include "common/string_utils.hpp"
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <string>
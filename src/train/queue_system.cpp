@@ -31,5 +31,24 @@ void QueueSystem::push(const QueueSystem::Query &query) { queue.push_back(query)
 auto QueueSystem::begin() -> list<Query>::iterator { return queue.begin(); }
 auto QueueSystem::end() -> list<Query>::iterator { return queue.end(); }
 void QueueSystem::erase(const list<Query>::iterator &it) { queue.erase(it); }
+auto QueueSystem::size() const -> size_t { return queue.size(); }
+void QueueSystem::save(SnapshotWriter &writer) {
+  writer.begin_section<Query>(SnapshotSection::QUEUE);
+  for (auto &query : queue) {
+    writer.append(query);
+  }
+  writer.end_section();
+}
+auto QueueSystem::load(SnapshotReader &reader) -> bool {
+  if (!reader.begin_section<Query>(SnapshotSection::QUEUE)) {
+    return false;
+  }
+  queue.clear();
+  Query query;
+  while (reader.read(query)) {
+    queue.push_back(query);
+  }
+  return true;
+}
 
 }  // namespace CrazyDave
@@ -1,14 +1,17 @@
 #include "train/train.hpp"
 namespace CrazyDave {
 
-TrainSystem::TrainSystem(ManagementSystem *m_sys) : m_sys_(m_sys) {}
+TrainSystem::TrainSystem() {
+  // query_ticket / query_transfer mostly probe stations that no train passes
+  station_storage_.EnableBloomFilter();
+}
+TrainSystem::TrainSystem(ManagementSystem *m_sys) : TrainSystem() { m_sys_ = m_sys; }
 auto TrainSystem::add_train(const std::string &train_id, int seat_num, const vector<std::string> &stations,
                             const vector<int> &prices, const Time &start_time, const vector<int> &travel_times,
                             const vector<int> &stop_over_times, const DateRange &sale_date, const char type) -> bool {
   auto train_hs = HashBytes(train_id.c_str());
-  vector<TrainMeta> meta_vec;
-  meta_storage_.find(train_hs, meta_vec);
-  if (!meta_vec.empty()) {
+  TrainMeta old_meta;
+  if (meta_storage_.find_first(train_hs, old_meta)) {
     return false;
   }
   TrainMeta meta{train_id, (int)stations.size(), seat_num, sale_date, type};
@@ -19,12 +22,10 @@ auto TrainSystem::add_train(const std::string &train_id, int seat_num, const vec
 }
 auto TrainSystem::delete_train(const std::string &train_id) -> bool {
   auto train_hs = HashBytes(train_id.c_str());
-  vector<TrainMeta> meta_vec;
-  meta_storage_.find(train_hs, meta_vec);
-  if (meta_vec.empty()) {
+  TrainMeta meta;
+  if (!meta_storage_.find_first(train_hs, meta)) {
     return false;
   }
-  auto &meta = meta_vec[0];
   if (meta.is_released_) {
     return false;
   }
@@ -34,17 +35,16 @@ auto TrainSystem::delete_train(const std::string &train_id) -> bool {
 }
 auto TrainSystem::release_train(const std::string &train_id) -> bool {
   auto train_hs = HashBytes(train_id.c_str());
-  vector<TrainMeta> meta_vec;
-  meta_storage_.find(train_hs, meta_vec);
-  if (meta_vec.empty()) {
+  TrainMeta meta;
+  if (!meta_storage_.find_first(train_hs, meta)) {
     return false;
   }
-  auto &meta = meta_vec[0];
   if (meta.is_released_) {
     return false;
   }
   meta_storage_.remove(train_hs, meta);
   meta.is_released_ = true;
+  seats_.allocate(meta);
   meta_storage_.insert(train_hs, meta);
   TrainArray array;
   t_io_.read_array(meta.index_, array);
@@ -52,24 +52,14 @@ auto TrainSystem::release_train(const std::string &train_id) -> bool {
     auto station_hs = HashBytes(array.stations_[i].c_str());
     station_storage_.insert(station_hs, {train_hs, i, array.time_ranges_[i], array.prices_[i]});
   }
-  int date_num = meta.sale_date_range_.second - meta.sale_date_range_.first + 1;
-  for (int i = 0; i < date_num; ++i) {
-    DateInfo seat;
-    seat.date_index_ = i;
-    std::fill_n(seat.seat_num_, meta.station_num_, meta.seat_num_);
-    date_info_storage_.insert({train_hs, i}, seat);
-  }
-
   return true;
 }
 auto TrainSystem::query_train(const std::string &train_id, const Date &date) -> bool {
   auto train_hs = HashBytes(train_id.c_str());
-  vector<TrainMeta> meta_vec;
-  meta_storage_.find(train_hs, meta_vec);
-  if (meta_vec.empty()) {
+  TrainMeta meta;
+  if (!meta_storage_.find_first(train_hs, meta)) {
     return false;
   }
-  auto &meta = meta_vec[0];
 
   if (meta.sale_date_range_.first > date || meta.sale_date_range_.second < date) {
     return false;
@@ -92,9 +82,8 @@ auto TrainSystem::query_train(const std::string &train_id, const Date &date) ->
     return true;
   }
   int j = date - meta.sale_date_range_.first;
-  vector<DateInfo> seat_vec;
-  date_info_storage_.find({train_hs, j}, seat_vec);
-  auto &seat_num = seat_vec[0].seat_num_;
+  int seat_num[100];
+  seats_.read(meta, j, seat_num);
   for (int i = 0; i < meta.station_num_; ++i) {
     std::cout << array.stations_[i] << " " << start_time + array.time_ranges_[i] << " " << array.prices_[i] << " ";
     if (i < meta.station_num_ - 1) {
@@ -112,18 +101,20 @@ void TrainSystem::query_ticket(const std::string &station_1, const std::string &
   auto station_hs_1 = HashBytes(station_1.c_str());
   auto station_hs_2 = HashBytes(station_2.c_str());
   vector<Record> record_vec_1;
-  vector<Record> record_vec_2;
-
-  station_storage_.find(station_hs_1, record_vec_1);
-  station_storage_.find(station_hs_2, record_vec_2);
   linked_hashmap<size_t, Record> rec_map;
-  for (auto &rec : record_vec_2) {
-    rec_map.insert({rec.train_hs, rec});
-  }
+  vector<size_t> station_keys;
+  station_keys.push_back(station_hs_1);
+  station_keys.push_back(station_hs_2);
+  station_storage_.find_batch(station_keys, [&](size_t i, const Record &rec) {
+    if (i == 0) {
+      record_vec_1.push_back(rec);
+    } else {
+      rec_map.insert({rec.train_hs, rec});
+    }
+  });
   for (auto &rec_1 : record_vec_1) {
-    vector<TrainMeta> meta_vec;
-    meta_storage_.find(rec_1.train_hs, meta_vec);
-    auto &meta = meta_vec[0];
+    TrainMeta meta;
+    meta_storage_.find_first(rec_1.train_hs, meta);
     int i1 = rec_1.index_;  // station index
     if (i1 == meta.station_num_ - 1 || !meta.is_released_) {
       continue;
@@ -143,20 +134,12 @@ void TrainSystem::query_ticket(const std::string &station_1, const std::string &
     if (i1 >= i2) {         // 倒过来开？
       continue;
     }
-    int min_num = meta.seat_num_;
     int j = depart_date - meta.sale_date_range_.first;  // date index
 
-    vector<DateInfo> seat_vec;
-    date_info_storage_.find({rec_1.train_hs, j}, seat_vec);
-
-    auto &seat_num = seat_vec[0].seat_num_;
-    for (int i = i1; i < i2; ++i) {
-      min_num = std::min(min_num, seat_num[i]);
-    }
-
     auto depart_date_time = DateTime{date, rec_1.time_range_.second.time};
     DateTime arrive_date_time{depart_date + rec_2.time_range_.first.date.day_, rec_2.time_range_.first.time};
-    res_vec.push_back({meta.train_id_, {depart_date_time, arrive_date_time}, rec_2.price_ - rec_1.price_, min_num});
+    res_vec.push_back({meta.train_id_, {depart_date_time, arrive_date_time}, rec_2.price_ - rec_1.price_,
+                       seats_.min(meta, j, i1, i2)});
   }
 
   if (type == QueryType::TIME) {
@@ -187,19 +170,21 @@ auto TrainSystem::query_transfer(const std::string &station_1, const std::string
   auto station_hs_1 = HashBytes(station_1.c_str());
   auto station_hs_2 = HashBytes(station_2.c_str());
   vector<Record> record_vec_1;
-  vector<Record> record_vec_2;
-  station_storage_.find(station_hs_1, record_vec_1);
-  station_storage_.find(station_hs_2, record_vec_2);
-
   linked_hashmap<size_t, int> rec_map;
-  for (auto &rec : record_vec_2) {
-    rec_map.insert({rec.train_hs, rec.index_});
-  }
+  vector<size_t> station_keys;
+  station_keys.push_back(station_hs_1);
+  station_keys.push_back(station_hs_2);
+  station_storage_.find_batch(station_keys, [&](size_t i, const Record &rec) {
+    if (i == 0) {
+      record_vec_1.push_back(rec);
+    } else {
+      rec_map.insert({rec.train_hs, rec.index_});
+    }
+  });
 
   for (auto &rec_1 : record_vec_1) {
-    vector<TrainMeta> meta_vec_1;
-    meta_storage_.find(rec_1.train_hs, meta_vec_1);
-    auto &meta_1 = meta_vec_1[0];
+    TrainMeta meta_1;
+    meta_storage_.find_first(rec_1.train_hs, meta_1);
     if (!meta_1.is_released_) {
       continue;
     }
@@ -213,25 +198,30 @@ auto TrainSystem::query_transfer(const std::string &station_1, const std::string
       continue;
     }
     int min_num_1 = meta_1.seat_num_;
-    vector<DateInfo> seat_vec_1;
-    date_info_storage_.find({rec_1.train_hs, j1}, seat_vec_1);
-    auto &seat_num_1 = seat_vec_1[0].seat_num_;
+    int seat_num_1[100];
+    seats_.read(meta_1, j1, seat_num_1);
+
+    // 沿途各站的过站记录一次性批量查询
+    station_keys.clear();
+    vector<vector<Record>> record_vecs_3;
+    for (int i = i1 + 1; i < meta_1.station_num_; ++i) {
+      station_keys.push_back(HashBytes(array_1.stations_[i].c_str()));
+      record_vecs_3.push_back({});
+    }
+    station_storage_.find_batch(station_keys, [&](size_t k, const Record &rec) { record_vecs_3[k].push_back(rec); });
 
+    vector<TransferResult> candidates;
     for (int i = i1 + 1; i < meta_1.station_num_; ++i) {
       min_num_1 = std::min(min_num_1, seat_num_1[i - 1]);
       auto &station_3 = array_1.stations_[i];
-      auto station_hs_3 = HashBytes(station_3.c_str());
-      vector<Record> record_vec_3;
-      station_storage_.find(station_hs_3, record_vec_3);
-      for (auto &rec_3 : record_vec_3) {
+      for (auto &rec_3 : record_vecs_3[i - i1 - 1]) {
         auto it = rec_map.find(rec_3.train_hs);
         if (it == rec_map.end() || rec_3.train_hs == rec_1.train_hs) {
           continue;
         }
 
-        vector<TrainMeta> meta_vec_2;
-        meta_storage_.find(rec_3.train_hs, meta_vec_2);
-        auto &meta_2 = meta_vec_2[0];
+        TrainMeta meta_2;
+        meta_storage_.find_first(rec_3.train_hs, meta_2);
 
         if (!meta_2.is_released_) {
           continue;
@@ -258,14 +248,6 @@ auto TrainSystem::query_transfer(const std::string &station_1, const std::string
           continue;
         }
         int j2 = depart_date_2 - meta_2.sale_date_range_.first;  // date index
-        int min_num_2 = meta_2.seat_num_;
-        vector<DateInfo> seat_vec_2;
-        date_info_storage_.find({rec_3.train_hs, j2}, seat_vec_2);
-        auto &seat_num_2 = seat_vec_2[0].seat_num_;
-
-        for (int k = i3; k < i2; ++k) {
-          min_num_2 = std::min(min_num_2, seat_num_2[k]);
-        }
         DateTime depart_date_time_1{date, array_1.time_ranges_[i1].second.time};  // 从station_1出发的时间
         DateTime arrive_date_time_1{depart_date_1 + array_1.time_ranges_[i].first.date.day_,
                                     array_1.time_ranges_[i].first.time};  // 到达station_3的时间
@@ -273,62 +255,66 @@ auto TrainSystem::query_transfer(const std::string &station_1, const std::string
                                     array_2.time_ranges_[i3].second.time};  // 从station_3出发的时间
         DateTime arrive_date_time_2{depart_date_2 + array_2.time_ranges_[i2].first.date.day_,
                                     array_2.time_ranges_[i2].first.time};  // 到达station_2的时间
-        auto *res_1 = new TransferResult{{meta_1.train_id_,
-                                          {
-                                              depart_date_time_1,
-                                              arrive_date_time_1,
-                                          },
-                                          array_1.prices_[i] - array_1.prices_[i1],
-                                          min_num_1},
-                                         {meta_2.train_id_,
-                                          {
-                                              depart_date_time_2,
-                                              arrive_date_time_2,
-                                          },
-                                          array_2.prices_[i2] - array_2.prices_[i3],
-                                          min_num_2},
-                                         station_3};
-        if (res == nullptr) {
-          success = true;
-          res = res_1;
-        } else {
-          if (type == QueryType::TIME) {
-            auto cmp = [](const TransferResult &t1, const TransferResult &t2) {
-              if (t1.total_time() != t2.total_time()) {
-                return t1.total_time() < t2.total_time();
-              }
-              if (t1.total_price() != t2.total_price()) {
-                return t1.total_price() < t2.total_price();
-              }
-              if (t1.res_1.train_id != t2.res_1.train_id) {
-                return t1.res_1.train_id < t2.res_1.train_id;
-              }
-              return t1.res_2.train_id < t2.res_2.train_id;
-            };
+        candidates.push_back({{meta_1.train_id_,
+                               {
+                                   depart_date_time_1,
+                                   arrive_date_time_1,
+                               },
+                               array_1.prices_[i] - array_1.prices_[i1],
+                               min_num_1},
+                              {meta_2.train_id_,
+                               {
+                                   depart_date_time_2,
+                                   arrive_date_time_2,
+                               },
+                               array_2.prices_[i2] - array_2.prices_[i3],
+                               seats_.min(meta_2, j2, i3, i2)},
+                              station_3});
+      }
+    }
 
-            if (cmp(*res_1, *res)) {
-              res = res_1;
-            } else {
-              delete res_1;
+    for (auto &candidate : candidates) {
+      auto *res_1 = new TransferResult{candidate};
+      if (res == nullptr) {
+        success = true;
+        res = res_1;
+      } else {
+        if (type == QueryType::TIME) {
+          auto cmp = [](const TransferResult &t1, const TransferResult &t2) {
+            if (t1.total_time() != t2.total_time()) {
+              return t1.total_time() < t2.total_time();
             }
+            if (t1.total_price() != t2.total_price()) {
+              return t1.total_price() < t2.total_price();
+            }
+            if (t1.res_1.train_id != t2.res_1.train_id) {
+              return t1.res_1.train_id < t2.res_1.train_id;
+            }
+            return t1.res_2.train_id < t2.res_2.train_id;
+          };
+
+          if (cmp(*res_1, *res)) {
+            res = res_1;
           } else {
-            auto cmp = [](const TransferResult &t1, const TransferResult &t2) {
-              if (t1.total_price() != t2.total_price()) {
-                return t1.total_price() < t2.total_price();
-              }
-              if (t1.total_time() != t2.total_time()) {
-                return t1.total_time() < t2.total_time();
-              }
-              if (t1.res_1.train_id != t2.res_1.train_id) {
-                return t1.res_1.train_id < t2.res_1.train_id;
-              }
-              return t1.res_2.train_id < t2.res_2.train_id;
-            };
-            if (cmp(*res_1, *res)) {
-              res = res_1;
-            } else {
-              delete res_1;
+            delete res_1;
+          }
+        } else {
+          auto cmp = [](const TransferResult &t1, const TransferResult &t2) {
+            if (t1.total_price() != t2.total_price()) {
+              return t1.total_price() < t2.total_price();
+            }
+            if (t1.total_time() != t2.total_time()) {
+              return t1.total_time() < t2.total_time();
+            }
+            if (t1.res_1.train_id != t2.res_1.train_id) {
+              return t1.res_1.train_id < t2.res_1.train_id;
             }
+            return t1.res_2.train_id < t2.res_2.train_id;
+          };
+          if (cmp(*res_1, *res)) {
+            res = res_1;
+          } else {
+            delete res_1;
           }
         }
       }
@@ -353,21 +339,16 @@ auto TrainSystem::buy_ticket(int time_stamp, const std::string &user_name, const
   }
 
   auto train_hs = HashBytes(train_id.c_str());
-  vector<TrainMeta> meta_vec;
-  meta_storage_.find(train_hs, meta_vec);
-  auto &meta = meta_vec[0];
-  if (!meta.is_released_ || num > meta.seat_num_) {
+  TrainMeta meta;
+  if (!meta_storage_.find_first(train_hs, meta) || !meta.is_released_ || num > meta.seat_num_) {
     return false;
   }
 
   TrainArray array;
   t_io_.read_array(meta.index_, array);
   short i1 = -1, i2 = -1, j;
-  int min_num = meta.seat_num_;
   Date depart_date;
 
-  vector<DateInfo> seat_vec;
-
   for (short i = 0; i < meta.station_num_; ++i) {
     if (array.stations_[i] == station_2) {
       i2 = i;
@@ -381,24 +362,16 @@ auto TrainSystem::buy_ticket(int time_stamp, const std::string &user_name, const
       if (meta.sale_date_range_.first > depart_date || meta.sale_date_range_.second < depart_date) {
         return false;
       }
-      date_info_storage_.find({train_hs, j}, seat_vec);
-    }
-    if (i1 != -1) {
-      min_num = std::min(min_num, seat_vec[0].seat_num_[i]);
     }
   }
 
   if (i1 == -1 || i2 == -1) {
     return false;
   }
+  int min_num = seats_.min(meta, j, i1, i2);
   auto user_hs = HashBytes(user_name.c_str());
   if (min_num >= num) {
-    auto &seat_num = seat_vec[0].seat_num_;
-    date_info_storage_.remove({train_hs, j}, seat_vec[0]);
-    for (int i = i1; i < i2; ++i) {
-      seat_num[i] -= num;
-    }
-    date_info_storage_.insert({train_hs, j}, seat_vec[0]);
+    seats_.add(meta, j, i1, i2, -num);
     std::cout << (array.prices_[i2] - array.prices_[i1]) * num << "\n";
     trade_storage_.insert(
         user_hs, Trade{time_stamp, Status::SUCCESS, train_id, DateTime{depart_date, {}} + array.time_ranges_[i1].second,
@@ -440,17 +413,10 @@ auto TrainSystem::refund_ticket(const std::string &user_name, int n) -> bool {
     auto train_hs = HashBytes(trade.train_id_.c_str());
 
     // 还原座位数量
-    vector<DateInfo> seat_vec;
-    date_info_storage_.find({train_hs, trade.date_index_}, seat_vec);
-    auto &seat = seat_vec[0];
-    auto &seat_num = seat.seat_num_;
-
-    date_info_storage_.remove({train_hs, trade.date_index_}, seat);
-    for (int i = trade.station_index_1_; i < trade.station_index_2_; ++i) {
-      seat_num[i] += trade.num_;
-    }
-    date_info_storage_.insert({train_hs, trade.date_index_}, seat);
-    check_queue(train_hs, trade.station_index_1_, trade.station_index_2_, trade.date_index_);
+    TrainMeta meta;
+    meta_storage_.find_first(train_hs, meta);
+    seats_.add(meta, trade.date_index_, trade.station_index_1_, trade.station_index_2_, trade.num_);
+    check_queue(train_hs, meta, trade.station_index_1_, trade.station_index_2_, trade.date_index_);
   } else {
     for (auto it = q_sys_.begin(); it != q_sys_.end(); ++it) {
       if (it->user_hs_ == user_hs && (int)(trade_vec.size() - it->trade_index_) == n) {
@@ -464,7 +430,8 @@ auto TrainSystem::refund_ticket(const std::string &user_name, int n) -> bool {
   trade_storage_.insert(user_hs, trade);
   return true;
 }
-void TrainSystem::check_queue(size_t train_hs, int station_index_1, int station_index_2, int date_index) {
+void TrainSystem::check_queue(size_t train_hs, const TrainMeta &meta, int station_index_1, int station_index_2,
+                              int date_index) {
   auto it = q_sys_.begin();
   while (it != q_sys_.end()) {
     if (it->train_hs_ != train_hs || it->date_index_ != date_index || it->station_index_2_ < station_index_1 ||
@@ -473,15 +440,7 @@ void TrainSystem::check_queue(size_t train_hs, int station_index_1, int station_
       continue;
     }
 
-    vector<DateInfo> seat_vec;
-    date_info_storage_.find({train_hs, date_index}, seat_vec);
-    auto &seat = seat_vec[0];
-    auto &seat_num = seat.seat_num_;
-    int min_num = seat_num[it->station_index_1_];
-    for (int i = it->station_index_1_; i < it->station_index_2_; ++i) {
-      min_num = std::min(min_num, seat_num[i]);
-    }
-    if (min_num < it->num_) {
+    if (seats_.min(meta, date_index, it->station_index_1_, it->station_index_2_) < it->num_) {
       ++it;
       continue;
     }
@@ -489,11 +448,7 @@ void TrainSystem::check_queue(size_t train_hs, int station_index_1, int station_
     auto query = *it;
     q_sys_.erase(it++);
 
-    date_info_storage_.remove({train_hs, date_index}, seat);
-    for (int i = query.station_index_1_; i < query.station_index_2_; ++i) {
-      seat_num[i] -= query.num_;
-    }
-    date_info_storage_.insert({train_hs, date_index}, seat);
+    seats_.add(meta, date_index, query.station_index_1_, query.station_index_2_, -query.num_);
     vector<Trade> trade_vec;
     trade_storage_.find(query.user_hs_, trade_vec);
     auto &trade = trade_vec[trade_vec.size() - 1 - query.trade_index_];
@@ -522,5 +477,73 @@ void TrainSystem::clear() {
   q_sys_.reset();
 }
 void TrainSystem::load_management_system(ManagementSystem *m_sys) { m_sys_ = m_sys; }
+void TrainSystem::print_stats(std::ostream &os) {
+  print_index_stats(os, meta_storage_);
+  print_index_stats(os, trade_storage_);
+  print_index_stats(os, station_storage_);
+  seats_.print_stats(os);
+  t_io_.print_stats(os);
+  os << "queue length " << q_sys_.size() << "\n";
+}
+void TrainSystem::save(SnapshotWriter &writer) {
+  vector<size_t> train_hs;
+  t_io_.save(writer, train_hs);
+  // 余票页按车次顺序写在车次信息前面，车次信息里的页号换成页在这一段里的序号
+  writer.begin_section<SeatMatrix::SeatPage>(SnapshotSection::SEAT_PAGES);
+  auto *page = new SeatMatrix::SeatPage;
+  meta_storage_.for_all([&](size_t, const TrainMeta &meta) {
+    for (int k = 0; k < SEAT_PAGE_NUM && meta.is_released_ && meta.seat_pages_[k] != INVALID_PAGE_ID; ++k) {
+      seats_.read_page(meta, k, *page);
+      writer.append(*page);
+    }
+  });
+  delete page;
+  writer.end_section();
+  writer.begin_section<size_t, TrainMeta>(SnapshotSection::TRAIN_METAS);
+  page_id_t seat_page_count = 0;
+  meta_storage_.for_all([&](size_t hs, TrainMeta meta) {
+    // 载入后车次数组的位置就是它的哈希在 train_hs 里的排名
+    meta.index_ = static_cast<int>(std::lower_bound(&train_hs[0], &train_hs[0] + train_hs.size(), hs) - &train_hs[0]);
+    for (int k = 0; k < SEAT_PAGE_NUM && meta.is_released_ && meta.seat_pages_[k] != INVALID_PAGE_ID; ++k) {
+      meta.seat_pages_[k] = seat_page_count++;
+    }
+    writer.append(hs, meta);
+  });
+  writer.end_section();
+  save_index<size_t, Trade>(writer, SnapshotSection::TRADES, trade_storage_);
+  save_index<size_t, Record>(writer, SnapshotSection::STATIONS, station_storage_);
+  q_sys_.save(writer);
+}
+auto TrainSystem::load(SnapshotReader &reader) -> bool {
+  if (!t_io_.load(reader) || !reader.begin_section<SeatMatrix::SeatPage>(SnapshotSection::SEAT_PAGES)) {
+    return false;
+  }
+  seats_.clear();
+  vector<page_id_t> seat_pages;
+  auto *page = new SeatMatrix::SeatPage;
+  while (reader.read(*page)) {
+    seat_pages.push_back(seats_.write_page(*page));
+  }
+  delete page;
+  if (!reader.begin_section<size_t, TrainMeta>(SnapshotSection::TRAIN_METAS)) {
+    return false;
+  }
+  meta_storage_.clear();
+  size_t hs;
+  TrainMeta meta;
+  while (reader.read(hs, meta)) {
+    for (int k = 0; k < SEAT_PAGE_NUM && meta.is_released_ && meta.seat_pages_[k] != INVALID_PAGE_ID; ++k) {
+      if (meta.seat_pages_[k] < 0 || meta.seat_pages_[k] >= static_cast<page_id_t>(seat_pages.size())) {
+        return false;
+      }
+      meta.seat_pages_[k] = seat_pages[meta.seat_pages_[k]];
+    }
+    meta_storage_.insert(hs, meta);
+  }
+  return load_tree<size_t, Trade>(reader, SnapshotSection::TRADES, trade_storage_) &&
+         load_tree<size_t, Record>(reader, SnapshotSection::STATIONS, station_storage_) && q_sys_.load(reader);
+}
+// 只重建增删最频繁的订单树，其余的树很小，余票矩阵原地更新不会变稀
+auto TrainSystem::compact(double fill_factor) -> bool { return trade_storage_.Compact(fill_factor); }
 
 }  // namespace CrazyDave
\ No newline at end of file